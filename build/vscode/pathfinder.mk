@@ -20,10 +20,10 @@ STATLibs = -static-libstdc++ -static-libgcc -static
 graphtestOBJs = $(ODIR)/graphtest.o $(ODIR)/cGraph.o $(ODIR)/cutest.o
 pathtestOBJs =  $(ODIR)/pathtest.o \
 	 $(ODIR)/cPathFinder.o $(ODIR)/cPathFinderReader.o $(ODIR)/cGraph.o \
-	 $(ODIR)/cRunWatch.o
+	 $(ODIR)/cGridGraph.o $(ODIR)/cKDTree.o $(ODIR)/cMaze.o $(ODIR)/cPathQuery.o $(ODIR)/cContractionHierarchy.o $(ODIR)/cLandmarks.o $(ODIR)/cDeltaStepping.o $(ODIR)/cRunWatch.o
 guiOBJs = $(ODIR)/pathgui.o \
 	 $(ODIR)/cPathFinder.o $(ODIR)/cPathFinderReader.o $(ODIR)/cGraph.o \
-	 $(ODIR)/cMaze.o $(ODIR)/cRunWatch.o
+	 $(ODIR)/cGridGraph.o $(ODIR)/cKDTree.o $(ODIR)/cMaze.o $(ODIR)/cPathQuery.o $(ODIR)/cContractionHierarchy.o $(ODIR)/cLandmarks.o $(ODIR)/cDeltaStepping.o $(ODIR)/cRunWatch.o
 
 ### COMPILE
 
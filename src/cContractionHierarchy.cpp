@@ -0,0 +1,570 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+#include "cContractionHierarchy.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// link while building hierarchy
+        struct sEdge
+        {
+            int node;   // node at other end of link
+            double cost;
+            int middle; // node bypassed by shortcut, -1 for original link
+        };
+
+        /// links in and out of every node while building hierarchy
+        class cBuildGraph
+        {
+        public:
+            std::vector<std::vector<sEdge>> myOut;
+            std::vector<std::vector<sEdge>> myIn;
+            std::vector<bool> myContracted;
+
+            cBuildGraph(int V)
+                : myOut(V), myIn(V), myContracted(V, false)
+            {
+            }
+
+            /// add link from u to v, or reduce its cost if it is already present
+            void add(int u, int v, double cost, int middle)
+            {
+                for (auto &e : myOut[u])
+                {
+                    if (e.node != v)
+                        continue;
+                    if (cost < e.cost)
+                    {
+                        e.cost = cost;
+                        e.middle = middle;
+                        for (auto &ei : myIn[v])
+                            if (ei.node == u)
+                            {
+                                ei.cost = cost;
+                                ei.middle = middle;
+                            }
+                    }
+                    return;
+                }
+                myOut[u].push_back({v, cost, middle});
+                myIn[v].push_back({u, cost, middle});
+            }
+        };
+
+        /** Local search for a path that avoids the node being contracted
+         *
+         * Search stops after a few nodes are settled, so some unneeded shortcuts may be added,
+         * which slows queries a little but never makes them wrong
+         */
+        class cWitness
+        {
+        public:
+            cWitness(const cBuildGraph &g)
+                : myGraph(g), myGeneration(0),
+                  myDist(g.myOut.size()), myStamp(g.myOut.size(), 0)
+            {
+            }
+
+            /** search from source
+             * @param[in] source
+             * @param[in] avoid node being contracted
+             * @param[in] maxCost no need to look for paths more expensive than this
+             * @param[in] maxSettled give up after settling this many nodes
+             */
+            void run(int source, int avoid, double maxCost, int maxSettled)
+            {
+                myGeneration++;
+                std::greater<queued_t> cheaper;
+                myHeap.clear();
+                set(source, 0);
+                myHeap.push_back(std::make_pair(0.0, source));
+                int settled = 0;
+                while (myHeap.size())
+                {
+                    std::pop_heap(myHeap.begin(), myHeap.end(), cheaper);
+                    double d = myHeap.back().first;
+                    int u = myHeap.back().second;
+                    myHeap.pop_back();
+                    if (d > dist(u))
+                        continue;
+                    if (d > maxCost || ++settled > maxSettled)
+                        return;
+                    for (auto &e : myGraph.myOut[u])
+                    {
+                        if (e.node == avoid || myGraph.myContracted[e.node])
+                            continue;
+                        double dv = d + e.cost;
+                        if (dv < dist(e.node))
+                        {
+                            set(e.node, dv);
+                            myHeap.push_back(std::make_pair(dv, e.node));
+                            std::push_heap(myHeap.begin(), myHeap.end(), cheaper);
+                        }
+                    }
+                }
+            }
+
+            /// cost of cheapest path found to node, INT_MAX if none
+            double dist(int n) const
+            {
+                if (myStamp[n] != myGeneration)
+                    return INT_MAX;
+                return myDist[n];
+            }
+
+        private:
+            const cBuildGraph &myGraph;
+            unsigned myGeneration;
+            std::vector<double> myDist;
+            std::vector<unsigned> myStamp;
+            typedef std::pair<double, int> queued_t; // ( cost from source, node index )
+            std::vector<queued_t> myHeap;
+
+            void set(int n, double d)
+            {
+                myDist[n] = d;
+                myStamp[n] = myGeneration;
+            }
+        };
+
+        /** shortcuts needed to contract node
+         * @param[in] g graph being built
+         * @param[in] witness search
+         * @param[in] v node to contract
+         * @param[in] add true to add the shortcuts, false to count them
+         * @param[in] maxSettled witness search limit
+         * @return number of shortcuts
+         */
+        static int shortcuts(
+            cBuildGraph &g,
+            cWitness &witness,
+            int v,
+            bool add,
+            int maxSettled)
+        {
+            int count = 0;
+            for (auto &ein : g.myIn[v])
+            {
+                int u = ein.node;
+                if (g.myContracted[u])
+                    continue;
+
+                // most expensive path through v from u
+                double maxCost = -1;
+                for (auto &eout : g.myOut[v])
+                    if (!g.myContracted[eout.node] && eout.node != u)
+                        maxCost = std::max(maxCost, ein.cost + eout.cost);
+                if (maxCost < 0)
+                    continue;
+
+                witness.run(u, v, maxCost, maxSettled);
+
+                for (auto &eout : g.myOut[v])
+                {
+                    int w = eout.node;
+                    if (g.myContracted[w] || w == u)
+                        continue;
+                    double cost = ein.cost + eout.cost;
+                    if (witness.dist(w) <= cost)
+                        continue; // path avoiding v is as cheap
+                    count++;
+                    if (add)
+                        g.add(u, w, cost, v);
+                }
+            }
+            return count;
+        }
+
+        void cContractionHierarchy::clear()
+        {
+            myNodeCount = 0;
+            myRank.clear();
+            myUpOffset.clear();
+            myUpNode.clear();
+            myUpCost.clear();
+            myUpMiddle.clear();
+            myDownOffset.clear();
+            myDownNode.clear();
+            myDownCost.clear();
+            myDownMiddle.clear();
+        }
+
+        void cContractionHierarchy::build(const cGraph &g)
+        {
+            clear();
+            int V = g.nodeCount();
+            cBuildGraph bg(V);
+            for (auto &n : g.graph())
+                for (auto &l : n.second.myLink)
+                {
+                    if (l.second.myCost < 0)
+                        throw std::runtime_error(
+                            "cContractionHierarchy::build negative link cost");
+                    if (n.first != l.first)
+                        bg.add(n.first, l.first, l.second.myCost, -1);
+                }
+
+            cWitness witness(bg);
+            const int simulateSettled = 50;
+            const int contractSettled = 500;
+            std::vector<int> deletedNeighbours(V, 0);
+
+            auto priority = [&](int v)
+            {
+                int degree = 0;
+                for (auto &e : bg.myIn[v])
+                    if (!bg.myContracted[e.node])
+                        degree++;
+                for (auto &e : bg.myOut[v])
+                    if (!bg.myContracted[e.node])
+                        degree++;
+                return 2 * (shortcuts(bg, witness, v, false, simulateSettled) - degree) + deletedNeighbours[v];
+            };
+
+            // least important nodes first
+            typedef std::pair<int, int> queued_t; // ( priority, node )
+            std::priority_queue<
+                queued_t,
+                std::vector<queued_t>,
+                std::greater<queued_t>>
+                Q;
+            for (int v = 0; v < V; v++)
+                Q.push(std::make_pair(priority(v), v));
+
+            myRank.resize(V);
+            int rank = 0;
+            while (Q.size())
+            {
+                int v = Q.top().second;
+                Q.pop();
+                if (bg.myContracted[v])
+                    continue;
+
+                // priority may have changed since queued, as neighbours were contracted
+                int p = priority(v);
+                if (Q.size() && p > Q.top().first)
+                {
+                    Q.push(std::make_pair(p, v));
+                    continue;
+                }
+
+                shortcuts(bg, witness, v, true, contractSettled);
+                bg.myContracted[v] = true;
+                myRank[v] = rank++;
+                // neighbours no longer need their links with v,
+                // which are kept by v for the hierarchy
+                auto isV = [v](const sEdge &e)
+                {
+                    return e.node == v;
+                };
+                for (auto &e : bg.myIn[v])
+                {
+                    deletedNeighbours[e.node]++;
+                    auto &out = bg.myOut[e.node];
+                    out.erase(std::remove_if(out.begin(), out.end(), isV), out.end());
+                }
+                for (auto &e : bg.myOut[v])
+                {
+                    deletedNeighbours[e.node]++;
+                    auto &in = bg.myIn[e.node];
+                    in.erase(std::remove_if(in.begin(), in.end(), isV), in.end());
+                }
+            }
+
+            // store each link with its less important node
+            myUpOffset.push_back(0);
+            myDownOffset.push_back(0);
+            for (int v = 0; v < V; v++)
+            {
+                for (auto &e : bg.myOut[v])
+                    if (myRank[e.node] > myRank[v])
+                    {
+                        myUpNode.push_back(e.node);
+                        myUpCost.push_back(e.cost);
+                        myUpMiddle.push_back(e.middle);
+                    }
+                myUpOffset.push_back(myUpNode.size());
+                for (auto &e : bg.myIn[v])
+                    if (myRank[e.node] > myRank[v])
+                    {
+                        myDownNode.push_back(e.node);
+                        myDownCost.push_back(e.cost);
+                        myDownMiddle.push_back(e.middle);
+                    }
+                myDownOffset.push_back(myDownNode.size());
+            }
+            myNodeCount = V;
+        }
+
+        int cContractionHierarchy::shortcutCount() const
+        {
+            return std::count_if(
+                       myUpMiddle.begin(), myUpMiddle.end(),
+                       [](int m)
+                       { return m >= 0; }) +
+                   std::count_if(
+                       myDownMiddle.begin(), myDownMiddle.end(),
+                       [](int m)
+                       { return m >= 0; });
+        }
+
+        /// working buffers for queries, one set for each thread
+        struct sQueryBuffers
+        {
+            unsigned myGeneration = 0;
+            std::vector<double> myDist[2]; // cost from start, cost to end
+            std::vector<int> myPred[2];    // next node toward start, toward end
+            std::vector<unsigned> myStamp[2];
+
+            void reset(int V)
+            {
+                if ((int)myStamp[0].size() < V)
+                    for (int d = 0; d < 2; d++)
+                    {
+                        myDist[d].resize(V);
+                        myPred[d].resize(V);
+                        myStamp[d].resize(V, 0);
+                    }
+                if (!++myGeneration)
+                {
+                    for (int d = 0; d < 2; d++)
+                        std::fill(myStamp[d].begin(), myStamp[d].end(), 0);
+                    myGeneration = 1;
+                }
+            }
+            double dist(int d, int n) const
+            {
+                if (myStamp[d][n] != myGeneration)
+                    return INT_MAX;
+                return myDist[d][n];
+            }
+            void reach(int d, int n, double cost, int pred)
+            {
+                myDist[d][n] = cost;
+                myPred[d][n] = pred;
+                myStamp[d][n] = myGeneration;
+            }
+        };
+
+        double cContractionHierarchy::path(
+            int start,
+            int end,
+            std::vector<int> &path) const
+        {
+            path.clear();
+            if (0 > start || start >= myNodeCount || 0 > end || end >= myNodeCount)
+                throw std::runtime_error(
+                    "cContractionHierarchy::path bad node");
+            if (start == end)
+            {
+                path.push_back(start);
+                return 0;
+            }
+
+            static thread_local sQueryBuffers B;
+            B.reset(myNodeCount);
+
+            // upward search from start, forward along links,
+            // and from end, backward along links
+            typedef std::pair<double, int> queued_t;
+            std::priority_queue<
+                queued_t,
+                std::vector<queued_t>,
+                std::greater<queued_t>>
+                Q[2];
+            B.reach(0, start, 0, -1);
+            Q[0].push(std::make_pair(0.0, start));
+            B.reach(1, end, 0, -1);
+            Q[1].push(std::make_pair(0.0, end));
+
+            double best = INT_MAX;
+            int meet = -1;
+            int d = 1;
+            while (Q[0].size() || Q[1].size())
+            {
+                // alternate direction
+                if (Q[1 - d].size())
+                    d = 1 - d;
+                auto &q = Q[d];
+
+                double cost = q.top().first;
+                int u = q.top().second;
+                q.pop();
+                if (cost >= best)
+                {
+                    // nothing cheaper this way
+                    q = std::priority_queue<
+                        queued_t,
+                        std::vector<queued_t>,
+                        std::greater<queued_t>>();
+                    continue;
+                }
+                if (cost > B.dist(d, u))
+                    continue; // already reached more cheaply
+
+                double other = B.dist(1 - d, u);
+                if (other != INT_MAX && cost + other < best)
+                {
+                    best = cost + other;
+                    meet = u;
+                }
+
+                // stall on demand: if u can be reached more cheaply through a more important node,
+                // the search will find that node's path and there is no need to continue from u
+                const std::vector<int> &offset = d ? myDownOffset : myUpOffset;
+                const std::vector<int> &node = d ? myDownNode : myUpNode;
+                const std::vector<double> &linkCost = d ? myDownCost : myUpCost;
+                const std::vector<int> &stallOffset = d ? myUpOffset : myDownOffset;
+                const std::vector<int> &stallNode = d ? myUpNode : myDownNode;
+                const std::vector<double> &stallCost = d ? myUpCost : myDownCost;
+                bool stalled = false;
+                for (int k = stallOffset[u]; k < stallOffset[u + 1]; k++)
+                    if (B.dist(d, stallNode[k]) + stallCost[k] < cost)
+                    {
+                        stalled = true;
+                        break;
+                    }
+                if (stalled)
+                    continue;
+
+                for (int k = offset[u]; k < offset[u + 1]; k++)
+                {
+                    int v = node[k];
+                    double dv = cost + linkCost[k];
+                    if (dv < B.dist(d, v))
+                    {
+                        B.reach(d, v, dv, u);
+                        q.push(std::make_pair(dv, v));
+                    }
+                }
+            }
+
+            if (meet < 0)
+                return INT_MAX;
+
+            for (int n = meet; n != -1; n = B.myPred[0][n])
+                path.push_back(n);
+            std::reverse(path.begin(), path.end());
+            for (int n = B.myPred[1][meet]; n != -1; n = B.myPred[1][n])
+                path.push_back(n);
+
+            unpack(path);
+            return best;
+        }
+
+        int cContractionHierarchy::middle(int u, int v) const
+        {
+            if (myRank[v] > myRank[u])
+            {
+                for (int k = myUpOffset[u]; k < myUpOffset[u + 1]; k++)
+                    if (myUpNode[k] == v)
+                        return myUpMiddle[k];
+            }
+            else
+            {
+                for (int k = myDownOffset[v]; k < myDownOffset[v + 1]; k++)
+                    if (myDownNode[k] == u)
+                        return myDownMiddle[k];
+            }
+            throw std::runtime_error(
+                "cContractionHierarchy::middle no link");
+        }
+
+        void cContractionHierarchy::unpack(std::vector<int> &path) const
+        {
+            std::vector<int> ret;
+            ret.push_back(path[0]);
+            std::vector<std::pair<int, int>> stack;
+            for (int k = 1; k < (int)path.size(); k++)
+            {
+                stack.push_back(std::make_pair(path[k - 1], path[k]));
+                while (stack.size())
+                {
+                    auto link = stack.back();
+                    stack.pop_back();
+                    int m = middle(link.first, link.second);
+                    if (m < 0)
+                    {
+                        ret.push_back(link.second);
+                        continue;
+                    }
+                    // first half of shortcut must be unpacked first, so goes on top of stack
+                    stack.push_back(std::make_pair(m, link.second));
+                    stack.push_back(std::make_pair(link.first, m));
+                }
+            }
+            path = ret;
+        }
+
+        static const char fileMagic[] = "ravench1";
+
+        template <class T>
+        static void writeVector(std::ostream &f, const std::vector<T> &v)
+        {
+            int n = v.size();
+            f.write((const char *)&n, sizeof(n));
+            f.write((const char *)v.data(), n * sizeof(T));
+        }
+        template <class T>
+        static void readVector(std::istream &f, std::vector<T> &v)
+        {
+            int n;
+            f.read((char *)&n, sizeof(n));
+            if (!f || n < 0)
+                throw std::runtime_error(
+                    "cContractionHierarchy::read bad file");
+            v.resize(n);
+            f.read((char *)v.data(), n * sizeof(T));
+        }
+
+        void cContractionHierarchy::write(std::ostream &f) const
+        {
+            f.write(fileMagic, sizeof(fileMagic));
+            f.write((const char *)&myNodeCount, sizeof(myNodeCount));
+            writeVector(f, myRank);
+            writeVector(f, myUpOffset);
+            writeVector(f, myUpNode);
+            writeVector(f, myUpCost);
+            writeVector(f, myUpMiddle);
+            writeVector(f, myDownOffset);
+            writeVector(f, myDownNode);
+            writeVector(f, myDownCost);
+            writeVector(f, myDownMiddle);
+        }
+
+        void cContractionHierarchy::read(std::istream &f)
+        {
+            clear();
+            char magic[sizeof(fileMagic)];
+            f.read(magic, sizeof(magic));
+            if (!f || memcmp(magic, fileMagic, sizeof(magic)))
+                throw std::runtime_error(
+                    "cContractionHierarchy::read not a hierarchy");
+            int V;
+            f.read((char *)&V, sizeof(V));
+            readVector(f, myRank);
+            readVector(f, myUpOffset);
+            readVector(f, myUpNode);
+            readVector(f, myUpCost);
+            readVector(f, myUpMiddle);
+            readVector(f, myDownOffset);
+            readVector(f, myDownNode);
+            readVector(f, myDownCost);
+            readVector(f, myDownMiddle);
+            if (!f ||
+                (int)myRank.size() != V ||
+                (int)myUpOffset.size() != V + 1 ||
+                (int)myDownOffset.size() != V + 1)
+            {
+                clear();
+                throw std::runtime_error(
+                    "cContractionHierarchy::read bad file");
+            }
+            myNodeCount = V;
+        }
+    }
+}
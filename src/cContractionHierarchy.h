@@ -0,0 +1,104 @@
+#pragma once
+#include <vector>
+#include <iostream>
+#include "cGraph.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief Contraction hierarchy, for fast repeated cheapest path queries on a fixed graph
+         *
+         * Preprocessing contracts the nodes one by one, least important first.
+         * Importance is the edge difference: the shortcuts needed to keep
+         * the cheapest paths between the node's neighbours, less the links removed,
+         * plus the number of neighbours already contracted, to spread the contractions evenly.
+         * A shortcut is added only if a local witness search finds no other path as cheap.
+         *
+         * Each link, original or shortcut, is stored with the less important of its two nodes,
+         * in compressed row storage: the upward links out of each node, for searches from the start,
+         * and the downward links into each node, reversed, for searches from the end.
+         *
+         * A query searches upward from both start and end, and the searches meet
+         * at the most important node of the cheapest path.
+         * Only a few hundred nodes are usually settled, whatever the size of the graph.
+         * The shortcuts on the path found are then unpacked into the links they replace.
+         *
+         * Link costs must not be negative.
+         * If the graph changes, the hierarchy must be built again.
+         */
+        class cContractionHierarchy
+        {
+        public:
+            cContractionHierarchy()
+                : myNodeCount(0)
+            {
+            }
+
+            /** build hierarchy
+             * @param[in] g graph, directed or undirected
+             *
+             * Exception thrown if a link cost is negative
+             */
+            void build(const cGraph &g);
+
+            /** find cheapest path
+             * @param[in] start node index
+             * @param[in] end node index
+             * @param[out] path node indices on path, start first, empty if no path
+             * @return path cost, INT_MAX if no path
+             *
+             * Does not change the hierarchy, so can run concurrently.
+             * Working buffers are kept by each thread between queries.
+             */
+            double path(
+                int start,
+                int end,
+                std::vector<int> &path) const;
+
+            /// number of nodes in graph hierarchy was built from, 0 if not built
+            int nodeCount() const
+            {
+                return myNodeCount;
+            }
+
+            /// number of shortcuts added
+            int shortcutCount() const;
+
+            /// write hierarchy to binary stream, so preprocessing need not be repeated
+            void write(std::ostream &f) const;
+
+            /** read hierarchy from binary stream written by write()
+             *
+             * Exception thrown if stream does not contain a hierarchy
+             */
+            void read(std::istream &f);
+
+            void clear();
+
+        private:
+            int myNodeCount;
+            std::vector<int> myRank; // order in which node was contracted
+
+            // upward links out of each node, from myUpOffset[n] to myUpOffset[n+1]
+            std::vector<int> myUpOffset;
+            std::vector<int> myUpNode;      // node at other end of link
+            std::vector<double> myUpCost;   // link cost
+            std::vector<int> myUpMiddle;    // node bypassed by shortcut, -1 for original link
+
+            // downward links into each node, from myDownOffset[n] to myDownOffset[n+1]
+            std::vector<int> myDownOffset;
+            std::vector<int> myDownNode;    // node at other end of link
+            std::vector<double> myDownCost;
+            std::vector<int> myDownMiddle;
+
+            /// node bypassed by link from u to v, -1 if original link
+            int middle(int u, int v) const;
+
+            /** replace shortcuts on path with the links they bypass
+             * @param[in,out] path
+             */
+            void unpack(std::vector<int> &path) const;
+        };
+    }
+}
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <stdexcept>
+#include "cDeltaStepping.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// threads wait at the barrier until all have reached it
+        class cBarrier
+        {
+        public:
+            cBarrier(int count)
+                : myCount(count), myWaiting(0), myGeneration(0)
+            {
+            }
+            void wait()
+            {
+                std::unique_lock<std::mutex> lock(myMutex);
+                int generation = myGeneration;
+                if (++myWaiting == myCount)
+                {
+                    myWaiting = 0;
+                    myGeneration++;
+                    myCondition.notify_all();
+                    return;
+                }
+                myCondition.wait(
+                    lock,
+                    [&]()
+                    { return generation != myGeneration; });
+            }
+
+        private:
+            std::mutex myMutex;
+            std::condition_variable myCondition;
+            int myCount;
+            int myWaiting;
+            int myGeneration;
+        };
+
+        /** workers kept waiting between jobs, so each step of the search does not start threads
+         *
+         * The calling thread is worker 0.
+         */
+        class cWorkerPool
+        {
+        public:
+            cWorkerPool(int count)
+                : myCount(count), myBarrier(count), myJob(nullptr), myfStop(false)
+            {
+                for (int w = 1; w < count; w++)
+                    myThread.emplace_back(
+                        [this, w]()
+                        {
+                            while (1)
+                            {
+                                myBarrier.wait();
+                                if (myfStop)
+                                    return;
+                                (*myJob)(w);
+                                myBarrier.wait();
+                            }
+                        });
+            }
+            ~cWorkerPool()
+            {
+                if (!myThread.size())
+                    return;
+                myfStop = true;
+                myBarrier.wait();
+                for (auto &t : myThread)
+                    t.join();
+            }
+
+            /** run job on every worker, returning when all have finished
+             * @param[in] job function called with worker number
+             */
+            void run(const std::function<void(int w)> &job)
+            {
+                if (myCount == 1)
+                {
+                    job(0);
+                    return;
+                }
+                myJob = &job;
+                myBarrier.wait();
+                job(0);
+                myBarrier.wait();
+            }
+
+        private:
+            int myCount;
+            cBarrier myBarrier;
+            const std::function<void(int w)> *myJob;
+            bool myfStop;
+            std::vector<std::thread> myThread;
+        };
+
+        double cDeltaStepping::linkRows(const cGraph &g)
+        {
+            int V = g.nodeCount();
+            int linkCount = 0;
+            double total = 0, maxCost = 0, minCost = INT_MAX;
+            myOffset.assign(V + 1, 0);
+            for (auto &n : g.graph())
+                for (auto &l : n.second.myLink)
+                {
+                    double c = l.second.myCost;
+                    if (c < 0)
+                        throw std::runtime_error(
+                            "cDeltaStepping::paths negative link cost");
+                    myOffset[n.first + 1]++;
+                    linkCount++;
+                    total += c;
+                    maxCost = std::max(maxCost, c);
+                    if (c > 0)
+                        minCost = std::min(minCost, c);
+                }
+            for (int n = 0; n < V; n++)
+                myOffset[n + 1] += myOffset[n];
+
+            myDeltaUsed = myDelta;
+            if (myDeltaUsed <= 0)
+            {
+                // Meyer and Sanders suggest about the link cost divided by the number of links per node,
+                // so a node's light links reach few nodes that will be reached again more cheaply.
+                // Four times that halves the steps, each with more nodes to share between the workers,
+                // for a few percent more links searched, on grids with random costs.
+                // Never less than the smallest cost, or the buckets would mostly be empty.
+                myDeltaUsed = 1;
+                if (linkCount)
+                {
+                    double mean = total / linkCount;
+                    double degree = (double)linkCount / V;
+                    myDeltaUsed = 4 * mean / degree;
+                    if (minCost < INT_MAX)
+                        myDeltaUsed = std::max(myDeltaUsed, minCost);
+                    if (myDeltaUsed <= 0)
+                        myDeltaUsed = 1;
+                }
+            }
+
+            // light links at start of each row, heavy from the end
+            myLightEnd.assign(myOffset.begin(), myOffset.end() - 1);
+            std::vector<int> heavyStart(myOffset.begin() + 1, myOffset.end());
+            myNode.resize(linkCount);
+            myCost.resize(linkCount);
+            for (auto &n : g.graph())
+                for (auto &l : n.second.myLink)
+                {
+                    int u = n.first;
+                    double c = l.second.myCost;
+                    int k = c <= myDeltaUsed ? myLightEnd[u]++ : --heavyStart[u];
+                    myNode[k] = l.first;
+                    myCost[k] = c;
+                }
+            return maxCost;
+        }
+
+        /// a cheaper path found to a node
+        struct sRelax
+        {
+            int node;
+            int from;
+            double cost;
+        };
+
+        void cDeltaStepping::paths(
+            const cGraph &g,
+            int start,
+            std::vector<double> &dist,
+            std::vector<int> &pred)
+        {
+            int V = g.nodeCount();
+            if (0 > start || start >= V)
+                throw std::runtime_error(
+                    "cDeltaStepping::paths bad start node");
+            double maxCost = linkRows(g);
+            double delta = myDeltaUsed;
+
+            // buckets in a cycle, long enough that every node waiting is in a different bucket for each cost
+            double cycleLength = floor(maxCost / delta) + 2;
+            if (cycleLength > (1 << 24))
+                throw std::runtime_error(
+                    "cDeltaStepping::paths delta too small for link costs");
+            int cycle = cycleLength;
+            std::vector<std::vector<int>> bucket(cycle);
+            auto bucketOf = [delta](double cost)
+            {
+                return (long long)(cost / delta);
+            };
+
+            int workerCount = myThreadCount;
+            if (workerCount < 1)
+                workerCount = std::thread::hardware_concurrency();
+            if (workerCount < 1)
+                workerCount = 1;
+            if (workerCount > V)
+                workerCount = V;
+            cWorkerPool pool(workerCount);
+
+            // fewer nodes than this to search from are searched by one worker
+            const int minParallel = 64 * workerCount;
+
+            dist.assign(V, INT_MAX);
+            pred.assign(V, -1);
+            dist[start] = 0;
+            bucket[0].push_back(start);
+            long long waiting = 1;
+
+            // cost reductions found, by worker that found them and worker that owns the node
+            std::vector<std::vector<std::vector<sRelax>>> relax(
+                workerCount,
+                std::vector<std::vector<sRelax>>(workerCount));
+            // nodes whose cost was reduced, by owner
+            std::vector<std::vector<int>> reduced(workerCount);
+
+            // search along light or heavy links from nodes
+            auto step = [&](const std::vector<int> &from, bool light)
+            {
+                int parts = (int)from.size() < minParallel ? 1 : workerCount;
+                pool.run(
+                    [&](int w)
+                    {
+                        if (w >= parts)
+                            return;
+                        int size = from.size();
+                        int first = (long long)size * w / parts;
+                        int last = (long long)size * (w + 1) / parts;
+                        for (int i = first; i < last; i++)
+                        {
+                            int u = from[i];
+                            double du = dist[u];
+                            int kfirst = light ? myOffset[u] : myLightEnd[u];
+                            int klast = light ? myLightEnd[u] : myOffset[u + 1];
+                            for (int k = kfirst; k < klast; k++)
+                            {
+                                int v = myNode[k];
+                                double dv = du + myCost[k];
+                                if (dv < dist[v])
+                                    relax[w][v % parts].push_back({v, u, dv});
+                            }
+                        }
+                    });
+                pool.run(
+                    [&](int w)
+                    {
+                        if (w >= parts)
+                            return;
+                        for (int p = 0; p < parts; p++)
+                        {
+                            for (auto &r : relax[p][w])
+                                if (r.cost < dist[r.node])
+                                {
+                                    dist[r.node] = r.cost;
+                                    pred[r.node] = r.from;
+                                    reduced[w].push_back(r.node);
+                                }
+                            relax[p][w].clear();
+                        }
+                    });
+                for (int w = 0; w < parts; w++)
+                {
+                    for (int v : reduced[w])
+                        bucket[bucketOf(dist[v]) % cycle].push_back(v);
+                    waiting += reduced[w].size();
+                    reduced[w].clear();
+                }
+            };
+
+            // stamps, so a node is searched from once in each step and each bucket
+            std::vector<long long> stepStamp(V, -1), bucketStamp(V, -1);
+            long long stepCount = 0;
+            std::vector<int> from, settled;
+
+            for (long long b = 0; waiting; b++)
+            {
+                auto &current = bucket[b % cycle];
+                settled.clear();
+                while (current.size())
+                {
+                    // nodes still in this bucket, not already reached more cheaply
+                    waiting -= current.size();
+                    from.clear();
+                    for (int v : current)
+                    {
+                        if (bucketOf(dist[v]) != b || stepStamp[v] == stepCount)
+                            continue;
+                        stepStamp[v] = stepCount;
+                        from.push_back(v);
+                        if (bucketStamp[v] != b)
+                        {
+                            bucketStamp[v] = b;
+                            settled.push_back(v);
+                        }
+                    }
+                    current.clear();
+                    stepCount++;
+                    step(from, true);
+                }
+
+                // costs in this bucket are now final
+                step(settled, false);
+            }
+        }
+    }
+}
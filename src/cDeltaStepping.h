@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include "cGraph.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief Delta-stepping, cheapest paths from one node to all, searched in parallel
+         *
+         * Nodes waiting are kept in buckets of width delta, by path cost.
+         * All the nodes in the cheapest bucket are searched from at once, by a pool of workers.
+         * Light links, costing no more than delta, can reach nodes in the same bucket,
+         * so they are searched from until the bucket stays empty.
+         * Heavy links can only reach later buckets,
+         * so they are searched from once, when the bucket is finished.
+         *
+         * Each worker owns the nodes whose index modulo the worker count is its number.
+         * The workers first collect the cost reductions found from the nodes they search from,
+         * then each applies the reductions to the nodes it owns,
+         * so a node's cost and previous node always change together, without locks.
+         *
+         * The costs found are the same as Dijkstra's.
+         * If two paths to a node cost the same, the previous node may differ.
+         *
+         * Worth using on graphs with millions of links, when several cores are free.
+         * Link costs must not be negative.
+         */
+        class cDeltaStepping
+        {
+        public:
+            cDeltaStepping()
+                : myDelta(0), myDeltaUsed(0), myThreadCount(0)
+            {
+            }
+
+            /** set bucket width
+             * @param[in] delta path cost range of each bucket, 0 to choose from the link costs
+             *
+             * A small delta does little work that is wasted, a large delta allows more parallelism.
+             */
+            void delta(double delta)
+            {
+                myDelta = delta;
+            }
+
+            /// set number of workers, 0 for one per hardware thread
+            void threads(int count)
+            {
+                myThreadCount = count;
+            }
+
+            /** find cheapest paths from start to every node
+             * @param[in] g graph
+             * @param[in] start node index
+             * @param[out] dist cost of cheapest path to each node, INT_MAX if no path
+             * @param[out] pred previous node on cheapest path to each node, -1 if none
+             *
+             * Exception thrown if start is not a node, or a link cost is negative
+             */
+            void paths(
+                const cGraph &g,
+                int start,
+                std::vector<double> &dist,
+                std::vector<int> &pred);
+
+            /// bucket width used by last search
+            double deltaUsed() const
+            {
+                return myDeltaUsed;
+            }
+
+        private:
+            double myDelta;
+            double myDeltaUsed;
+            int myThreadCount;
+
+            // links out of each node, from myOffset[n] to myOffset[n+1],
+            // light links first, to myLightEnd[n]
+            std::vector<int> myOffset;
+            std::vector<int> myLightEnd;
+            std::vector<int> myNode; // node at other end of link
+            std::vector<double> myCost;
+
+            /** store links, light first, choosing delta if not set
+             * @return largest link cost
+             */
+            double linkRows(const cGraph &g);
+        };
+    }
+}
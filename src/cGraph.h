@@ -46,7 +46,7 @@ namespace raven
             {
                 myLink.clear();
             }
-            double linkCost(int dst)
+            double linkCost(int dst) const
             {
                 auto it = myLink.find(dst);
                 if (it == myLink.end())
@@ -58,11 +58,19 @@ namespace raven
                 return myLink.size();
             }
             std::string myName;
-            int myCost;
             std::string myColor;
             nodeOutEdgesMap_t myLink;
         };
 
+        /// role of a node in a pickup and delivery problem
+        enum class eNodeRole
+        {
+            none,
+            driver,
+            cargo,
+            destination
+        };
+
         typedef std::map<int,cNode> nodeMap_t;
         typedef std::pair<std::pair<int, int>, cLink> link_t;
 
@@ -72,16 +80,22 @@ namespace raven
         public:
             typedef std::map<std::pair<int, int>, cLink> linkmap_t;
 
-            cGraph() : myfDirected(false) {}
+            cGraph() : myfDirected(false), myVersion(0) {}
 
             void clear()
             {
+                changed();
                 myG.clear();
                 myMapNameToIndex.clear();
                 myfDirected = false;
+                myNodeX.clear();
+                myNodeY.clear();
+                myNodeWeight.clear();
+                myNodeRole.clear();
             }
             void makeNodes(int count)
             {
+                changed();
                 myG.clear();
                 for (int k = 0; k < count; k++)
                     myG.insert(std::make_pair(k, cNode(std::to_string(k))));
@@ -131,12 +145,14 @@ namespace raven
                 if (0 > u || u > myG.size() || 0 > v || v > myG.size())
                     throw std::runtime_error(
                         "addLink bad node index");
+                changed();
                 myG.find(u)->second.myLink.insert(std::make_pair(v, cLink(cost)));
                 if (!myfDirected)
                     myG.find(v)->second.myLink.insert(std::make_pair(u, cLink(cost)));
             }
             void addLinkFast(int u, int v)
             {
+                changed();
                 myG.find(u)->second.myLink.insert(std::make_pair(v, cLink()));
             }
             /** Find node by name
@@ -171,6 +187,7 @@ namespace raven
                 {
                     // node does not exist, create a new one
                     // with a new index and add it to the graph
+                    changed();
                     n = myG.size();
                     myG.insert(std::make_pair(n, cNode(name)));
                     myMapNameToIndex[name] = n;
@@ -184,16 +201,19 @@ namespace raven
                 if (it == myG.end())
                     throw std::runtime_error(
                         "cGraph::findNode bad index");
+                changed();
                 return it->second;
             }
 
             cLink &findLink(int u, int v)
             {
+                changed();
                 return myG.at(u).myLink.at(v);
             }
 
             void removeLink(int u, int v)
             { 
+                changed();
                 try
                 {
                     //std::cout << "remove link " << userName(u) << " " << userName(v) << "\n";
@@ -210,6 +230,7 @@ namespace raven
             }
             void removeAllLinks()
             {
+                changed();
                 for (auto &n : myG)
                     n.second.removeAllLinks();
             }
@@ -218,6 +239,7 @@ namespace raven
                 auto it = myG.find(n);
                 if (it == myG.end())
                     return;
+                changed();
                 myG.erase(it);
             }
 
@@ -251,6 +273,7 @@ namespace raven
 
             std::map<int, cNode> &nodes()
             {
+                changed();
                 return myG;
             }
             /// map of all links, keyed by src, dst pair
@@ -286,6 +309,7 @@ namespace raven
              */
             cNode &node(int i)
             {
+                changed();
                 return myG.at(i);
             }
             /// @brief node index
@@ -338,6 +362,7 @@ namespace raven
                 if (itv == itu->second.myLink.end())
                     throw std::runtime_error(
                         "link bad index");
+                changed();
                 return itv->second;
             }
             bool includes_link(int u, int v)
@@ -360,23 +385,18 @@ namespace raven
  * @return cost of link between u and v
  * If u and v are not adjacent, returns INT_MAX
  */
-            double cost(int u, int v)
+            double cost(int u, int v) const
             {
-                try
-                {
-                    std::cout << "cGraph::cost "<< userName(u) <<" "<< userName(v) <<" "<<link(u, v).myCost<<"\n";
-                    return link(u, v).myCost;
-                }
-                catch (...)
-                {
+                auto itu = myG.find(u);
+                if (itu == myG.end())
                     return INT_MAX;
-                }
+                return itu->second.linkCost(v);
             }
             /** Adjacent nodes
          * @param[in] i index of node to find which nodes it connects to
          * @return vector of connected node indices
          */
-            std::vector<int> adjacent(int i)
+            std::vector<int> adjacent(int i) const
             {
                 std::vector<int> ret;
                 auto it = myG.find(i);
@@ -418,6 +438,7 @@ namespace raven
             /// copy nodes, but not the links
             void copyNodes(const cGraph &other)
             {
+                changed();
                 for (auto &n : other.myG)
                 {
                     myG.insert(std::make_pair(n.first, cNode(n.second.myName)));
@@ -429,8 +450,67 @@ namespace raven
                 return myG;
             }
 
+            /** count of changes to the graph, so results of preprocessing can be checked
+             *
+             * Increased by every method that can change the nodes or links,
+             * including those returning a reference that a link cost could be changed through.
+             */
+            unsigned version() const
+            {
+                return myVersion;
+            }
+
+            /** set node location
+             * @param[in] n node index
+             * @param[in] x
+             * @param[in] y
+             */
+            void location(int n, double x, double y)
+            {
+                column(myNodeX, n) = x;
+                column(myNodeY, n) = y;
+            }
+            /// node x location, 0 if not set
+            double x(int n) const
+            {
+                return columnValue(myNodeX, n);
+            }
+            /// node y location, 0 if not set
+            double y(int n) const
+            {
+                return columnValue(myNodeY, n);
+            }
+            /// true if any node has a location
+            bool hasLocations() const
+            {
+                return myNodeX.size() > 0;
+            }
+
+            /// set node weight
+            void weight(int n, int w)
+            {
+                column(myNodeWeight, n) = w;
+            }
+            /// node weight, 0 if not set
+            int weight(int n) const
+            {
+                return columnValue(myNodeWeight, n);
+            }
+
+            /// set node role
+            void role(int n, eNodeRole r)
+            {
+                column(myNodeRole, n) = r;
+            }
+            /// node role, none if not set
+            eNodeRole role(int n) const
+            {
+                return columnValue(myNodeRole, n);
+            }
+
             std::vector< cNode* > vpNode()
             {
+                changed();
                 std::vector< cNode* > ret;
                 for( auto& n : myG )
                 {
@@ -455,6 +535,42 @@ namespace raven
          * two directed links in opposite direction are added between the end nodes
          */
             bool myfDirected;
+
+            unsigned myVersion; // increased whenever nodes or links may have changed
+
+            /// note that nodes or links may have changed
+            void changed()
+            {
+                myVersion++;
+            }
+
+            /* node attributes, stored in columns indexed by node index
+
+            The columns grow when an attribute is set for a node with a higher index,
+            nodes whose attribute has never been set get the default value
+            */
+            std::vector<double> myNodeX;
+            std::vector<double> myNodeY;
+            std::vector<int> myNodeWeight;
+            std::vector<eNodeRole> myNodeRole;
+
+            template <class T>
+            static T &column(std::vector<T> &c, int n)
+            {
+                if (0 > n)
+                    throw std::runtime_error(
+                        "cGraph node attribute bad index");
+                if (n >= (int)c.size())
+                    c.resize(n + 1, T());
+                return c[n];
+            }
+            template <class T>
+            static T columnValue(const std::vector<T> &c, int n)
+            {
+                if (0 > n || n >= (int)c.size())
+                    return T();
+                return c[n];
+            }
         };
 
         /// index of link source
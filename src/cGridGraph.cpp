@@ -0,0 +1,149 @@
+#include <cmath>
+#include <queue>
+#include <algorithm>
+#include <stdexcept>
+#include "cGridGraph.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        // neighbour offsets, orthogonal first then diagonal
+        static const int dRow[] = {-1, 1, 0, 0, -1, -1, 1, 1};
+        static const int dCol[] = {0, 0, -1, 1, -1, 1, -1, 1};
+
+        void cGridGraph::heights(
+            int rowCount,
+            int colCount,
+            const std::vector<float> &height)
+        {
+            if (rowCount < 1 || colCount < 1 ||
+                (int)height.size() != rowCount * colCount)
+                throw std::runtime_error(
+                    "cGridGraph::heights bad grid");
+            myHeight.size(rowCount, colCount);
+            for (int row = 0; row < rowCount; row++)
+                for (int col = 0; col < colCount; col++)
+                    myHeight(row, col) = height[row * colCount + col];
+        }
+
+        double cGridGraph::cost(int u, int v) const
+        {
+            double length = 1;
+            if (row(u) != row(v) && col(u) != col(v))
+                length = sqrt(2.0);
+            double delta = myHeight[v] - myHeight[u];
+            return length + delta * delta;
+        }
+
+        float cGridGraph::remaining(int row, int col) const
+        {
+            int dr = abs(row - myEndRow);
+            int dc = abs(col - myEndCol);
+            if (!myfDiagonal)
+                return dr + dc;
+
+            // octile distance
+            int diag = std::min(dr, dc);
+            return (dr + dc - 2 * diag) + diag * (float)sqrt(2.0);
+        }
+
+        std::vector<int> cGridGraph::path(bool astar) const
+        {
+            std::vector<int> ret;
+
+            if (0 > myStart || 0 > myEnd)
+                throw std::runtime_error(
+                    "cGridGraph::path start or end not set");
+
+            // working values are indexed by cell index, so they are tiled like the heights
+            int V = myHeight.bufferSize();
+
+            int neighbourCount = 4;
+            if (myfDiagonal)
+                neighbourCount = 8;
+            const float diagonalLength = sqrt(2.0);
+            int rows = rowCount();
+            int cols = colCount();
+
+            // cost to reach each cell from start
+            std::vector<float> dist(V, INFINITY);
+
+            // direction to each cell from previous cell on path, +1 so 0 means not reached
+            std::vector<unsigned char> pred(V, 0);
+
+            // true when cheapest path to cell is known
+            std::vector<bool> done(V, false);
+
+            // queue of cells to search from, cheapest estimated total cost first
+            typedef std::pair<float, int> queued_t; // ( estimated cost, cell index )
+            std::priority_queue<
+                queued_t,
+                std::vector<queued_t>,
+                std::greater<queued_t>>
+                Q;
+
+            dist[myStart] = 0;
+            Q.push(std::make_pair(0.0f, myStart));
+
+            while (Q.size())
+            {
+                int u = Q.top().second;
+                Q.pop();
+                if (done[u])
+                    continue;
+                done[u] = true;
+                if (u == myEnd)
+                    break;
+
+                int ur = row(u);
+                int uc = col(u);
+                for (int k = 0; k < neighbourCount; k++)
+                {
+                    int vr = ur + dRow[k];
+                    int vc = uc + dCol[k];
+                    if (0 > vr || vr >= rows || 0 > vc || vc >= cols)
+                        continue;
+                    int v = myHeight.offset(vr, vc);
+                    if (done[v])
+                        continue;
+
+                    // link cost, as cost( u, v ) but using the known direction
+                    float delta = myHeight[v] - myHeight[u];
+                    float linkCost = delta * delta;
+                    if (k < 4)
+                        linkCost += 1;
+                    else
+                        linkCost += diagonalLength;
+
+                    float d = dist[u] + linkCost;
+                    if (d < dist[v])
+                    {
+                        dist[v] = d;
+                        pred[v] = k + 1;
+                        float estimate = d;
+                        if (astar)
+                            estimate += remaining(vr, vc);
+                        Q.push(std::make_pair(estimate, v));
+                    }
+                }
+            }
+
+            if (!done[myEnd])
+                return ret; // there is no path
+
+            // pick out path, starting at end and finishing at start
+            int v = myEnd;
+            ret.push_back(v);
+            while (v != myStart)
+            {
+                int k = pred[v] - 1;
+                v = myHeight.offset(row(v) - dRow[k], col(v) - dCol[k]);
+                ret.push_back(v);
+            }
+            std::reverse(ret.begin(), ret.end());
+
+            return ret;
+        }
+    }
+}
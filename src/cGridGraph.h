@@ -0,0 +1,125 @@
+#pragma once
+#include <vector>
+#include "cTiledGrid.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief Grid of cells with heights, searched without creating nodes or links
+         *
+         * Each cell links to its orthogonal neighbours,
+         * and to its diagonal neighbours if requested.
+         * The links and their costs are calculated when needed from the heights,
+         * so memory is proportional to the number of cells.
+         *
+         * The cost of a link is its length plus the square of the change in height
+         *
+         * The heights, and the search working values, are stored in tiles
+         * so that neighbours above and below are close in memory.
+         * Cells are referred to by their index, the offset into the tiled storage,
+         * use index(), row() and col() to convert.
+         */
+        class cGridGraph
+        {
+        public:
+            cGridGraph()
+                : myfDiagonal(false),
+                  myStart(-1), myEnd(-1)
+            {
+            }
+
+            /** set cell heights
+             * @param[in] rowCount
+             * @param[in] colCount
+             * @param[in] height cell heights, row by row
+             */
+            void heights(
+                int rowCount,
+                int colCount,
+                const std::vector<float> &height);
+
+            /// set links to diagonal neighbours, default orthogonal only
+            void diagonal(bool f = true)
+            {
+                myfDiagonal = f;
+            }
+
+            /// set starting cell, 0-based
+            void start(int row, int col)
+            {
+                myStart = index(row, col);
+            }
+
+            /// set ending cell, 0-based
+            void end(int row, int col)
+            {
+                myEnd = index(row, col);
+                myEndRow = row;
+                myEndCol = col;
+            }
+
+            int rowCount() const
+            {
+                return myHeight.rowCount();
+            }
+            int colCount() const
+            {
+                return myHeight.colCount();
+            }
+
+            /** cell index
+             * @param[in] row 0-based
+             * @param[in] col 0-based
+             * @return cell index
+             *
+             * Exception thrown if cell is not in grid
+             */
+            int index(int row, int col) const
+            {
+                if (0 > row || row >= rowCount() || 0 > col || col >= colCount())
+                    throw std::runtime_error(
+                        "cGridGraph::index cell not in grid");
+                return myHeight.offset(row, col);
+            }
+            int row(int cell) const
+            {
+                return myHeight.row(cell);
+            }
+            int col(int cell) const
+            {
+                return myHeight.col(cell);
+            }
+            float height(int cell) const
+            {
+                return myHeight[cell];
+            }
+
+            /** cost of link between neighbouring cells
+             * @param[in] u cell index
+             * @param[in] v cell index, must be a neighbour of u
+             * @return link length plus square of change in height
+             */
+            double cost(int u, int v) const;
+
+            /** Find cheapest path from start to end
+             * @param[in] astar true to use A*, false for Dijkstra, default true
+             * @return cell indices on path, start first, empty if no path
+             *
+             * A* uses the number of steps remaining as its heuristic,
+             * which never overestimates because every link costs at least its length
+             */
+            std::vector<int> path(bool astar = true) const;
+
+        private:
+            cTiledGrid<float> myHeight; // cell heights
+            bool myfDiagonal;            // true if diagonal neighbours are linked
+            int myStart;                 // starting cell index
+            int myEnd;                   // ending cell index
+            int myEndRow, myEndCol;
+
+            /// lower bound of cost from cell to end
+            float remaining(int row, int col) const;
+        };
+    }
+}
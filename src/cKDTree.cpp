@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <stdexcept>
+#include "cKDTree.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        void cKDTree::build(
+            const std::vector<double> &vx,
+            const std::vector<double> &vy,
+            const std::vector<int> &vid)
+        {
+            if (vx.size() != vy.size() || vx.size() != vid.size())
+                throw std::runtime_error(
+                    "cKDTree::build bad points");
+            myPoint.clear();
+            for (int k = 0; k < (int)vid.size(); k++)
+                myPoint.push_back({vx[k], vy[k], vid[k]});
+            build(0, myPoint.size(), true);
+        }
+
+        void cKDTree::build(int lo, int hi, bool xsplit)
+        {
+            if (hi - lo < 2)
+                return;
+            int mid = (lo + hi) / 2;
+            std::nth_element(
+                myPoint.begin() + lo,
+                myPoint.begin() + mid,
+                myPoint.begin() + hi,
+                [xsplit](const sPoint &a, const sPoint &b)
+                {
+                    if (xsplit)
+                        return a.x < b.x;
+                    return a.y < b.y;
+                });
+            build(lo, mid, !xsplit);
+            build(mid + 1, hi, !xsplit);
+        }
+
+        int cKDTree::nearest(double x, double y) const
+        {
+            double bestDist2 = 0;
+            int bestId = -1;
+            nearest(0, myPoint.size(), true, x, y, bestDist2, bestId);
+            return bestId;
+        }
+
+        void cKDTree::nearest(
+            int lo, int hi, bool xsplit,
+            double x, double y,
+            double &bestDist2, int &bestId) const
+        {
+            if (lo >= hi)
+                return;
+            int mid = (lo + hi) / 2;
+            const sPoint &p = myPoint[mid];
+
+            double dx = x - p.x;
+            double dy = y - p.y;
+            double d2 = dx * dx + dy * dy;
+            if (bestId == -1 ||
+                d2 < bestDist2 ||
+                (d2 == bestDist2 && p.id < bestId))
+            {
+                bestDist2 = d2;
+                bestId = p.id;
+            }
+
+            // search the side of the split containing the location first
+            double delta = xsplit ? dx : dy;
+            if (delta < 0)
+            {
+                nearest(lo, mid, !xsplit, x, y, bestDist2, bestId);
+                if (delta * delta <= bestDist2)
+                    nearest(mid + 1, hi, !xsplit, x, y, bestDist2, bestId);
+            }
+            else
+            {
+                nearest(mid + 1, hi, !xsplit, x, y, bestDist2, bestId);
+                if (delta * delta <= bestDist2)
+                    nearest(lo, mid, !xsplit, x, y, bestDist2, bestId);
+            }
+        }
+
+        std::vector<int> cKDTree::nearest(double x, double y, int k) const
+        {
+            std::vector<found_t> found;
+            if (k > 0)
+                nearest(0, myPoint.size(), true, x, y, k, found);
+            std::sort_heap(found.begin(), found.end());
+            std::vector<int> ret;
+            for (auto &f : found)
+                ret.push_back(f.second);
+            return ret;
+        }
+
+        void cKDTree::nearest(
+            int lo, int hi, bool xsplit,
+            double x, double y, int k,
+            std::vector<found_t> &found) const
+        {
+            if (lo >= hi)
+                return;
+            int mid = (lo + hi) / 2;
+            const sPoint &p = myPoint[mid];
+
+            double dx = x - p.x;
+            double dy = y - p.y;
+            found_t f(dx * dx + dy * dy, p.id);
+            if ((int)found.size() < k)
+            {
+                found.push_back(f);
+                std::push_heap(found.begin(), found.end());
+            }
+            else if (f < found.front())
+            {
+                // replace the furthest found so far
+                std::pop_heap(found.begin(), found.end());
+                found.back() = f;
+                std::push_heap(found.begin(), found.end());
+            }
+
+            // search the side of the split containing the location first
+            double delta = xsplit ? dx : dy;
+            int nearLo = mid + 1, nearHi = hi, farLo = lo, farHi = mid;
+            if (delta < 0)
+            {
+                nearLo = lo;
+                nearHi = mid;
+                farLo = mid + 1;
+                farHi = hi;
+            }
+            nearest(nearLo, nearHi, !xsplit, x, y, k, found);
+            if ((int)found.size() < k || delta * delta <= found.front().first)
+                nearest(farLo, farHi, !xsplit, x, y, k, found);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <vector>
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief 2D k-d tree of points, for nearest neighbour queries
+         *
+         * The tree is stored implicitly in one vector:
+         * the point splitting a range of the vector is at the middle of the range,
+         * the points in the first half are on the low side of the split,
+         * those in the second half on the high side.
+         * The split alternates between x and y at each level.
+         */
+        class cKDTree
+        {
+        public:
+            /** build tree
+             * @param[in] vx point x locations
+             * @param[in] vy point y locations
+             * @param[in] vid point identifiers, returned by nearest()
+             */
+            void build(
+                const std::vector<double> &vx,
+                const std::vector<double> &vy,
+                const std::vector<int> &vid);
+
+            /** nearest point to a location
+             * @param[in] x
+             * @param[in] y
+             * @return identifier of nearest point, -1 if tree is empty
+             *
+             * If several points are equally near, the smallest identifier is returned
+             */
+            int nearest(double x, double y) const;
+
+            /** nearest points to a location
+             * @param[in] x
+             * @param[in] y
+             * @param[in] k maximum number of points to return
+             * @return identifiers of up to k nearest points, nearest first
+             */
+            std::vector<int> nearest(double x, double y, int k) const;
+
+            int size() const
+            {
+                return (int)myPoint.size();
+            }
+
+        private:
+            struct sPoint
+            {
+                double x;
+                double y;
+                int id;
+            };
+            std::vector<sPoint> myPoint;
+
+            void build(int lo, int hi, bool xsplit);
+
+            void nearest(
+                int lo, int hi, bool xsplit,
+                double x, double y,
+                double &bestDist2, int &bestId) const;
+
+            typedef std::pair<double, int> found_t; // ( distance squared, id )
+
+            /// search for k nearest, found is a max heap of the nearest so far
+            void nearest(
+                int lo, int hi, bool xsplit,
+                double x, double y, int k,
+                std::vector<found_t> &found) const;
+        };
+    }
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <atomic>
+#include <stdexcept>
+#include "cLandmarks.h"
+#include "cWorkers.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// links out of every node, in compressed rows
+        struct sLinkRows
+        {
+            std::vector<int> offset; // links of node n from offset[n] to offset[n+1]
+            std::vector<int> node;   // node at other end of link
+            std::vector<double> cost;
+        };
+
+        /** links of graph in compressed rows
+         * @param[in] g graph
+         * @param[in] reverse true for links into each node, reversed
+         */
+        static sLinkRows linkRows(const cGraph &g, bool reverse)
+        {
+            int V = g.nodeCount();
+            sLinkRows rows;
+            rows.offset.resize(V + 1, 0);
+            for (auto &n : g.graph())
+                for (auto &l : n.second.myLink)
+                {
+                    if (l.second.myCost < 0)
+                        throw std::runtime_error(
+                            "cLandmarks::build negative link cost");
+                    rows.offset[(reverse ? l.first : n.first) + 1]++;
+                }
+            for (int n = 0; n < V; n++)
+                rows.offset[n + 1] += rows.offset[n];
+            rows.node.resize(rows.offset[V]);
+            rows.cost.resize(rows.offset[V]);
+            std::vector<int> next(rows.offset.begin(), rows.offset.end() - 1);
+            for (auto &n : g.graph())
+                for (auto &l : n.second.myLink)
+                {
+                    int u = reverse ? l.first : n.first;
+                    int k = next[u]++;
+                    rows.node[k] = reverse ? n.first : l.first;
+                    rows.cost[k] = l.second.myCost;
+                }
+            return rows;
+        }
+
+        /// cost of cheapest path from start to every node, INT_MAX if no path
+        static void dijkstra(
+            const sLinkRows &rows,
+            int start,
+            std::vector<double> &dist)
+        {
+            dist.assign(rows.offset.size() - 1, INT_MAX);
+            typedef std::pair<double, int> queued_t;
+            std::priority_queue<
+                queued_t,
+                std::vector<queued_t>,
+                std::greater<queued_t>>
+                Q;
+            dist[start] = 0;
+            Q.push(std::make_pair(0.0, start));
+            while (Q.size())
+            {
+                double d = Q.top().first;
+                int u = Q.top().second;
+                Q.pop();
+                if (d > dist[u])
+                    continue;
+                for (int k = rows.offset[u]; k < rows.offset[u + 1]; k++)
+                {
+                    double dv = d + rows.cost[k];
+                    int v = rows.node[k];
+                    if (dv < dist[v])
+                    {
+                        dist[v] = dv;
+                        Q.push(std::make_pair(dv, v));
+                    }
+                }
+            }
+        }
+
+        /// stored cost of node that cannot be reached
+        static const float unreached = INT_MAX;
+
+        void cLandmarks::clear()
+        {
+            myNodeCount = 0;
+            myLandmark.clear();
+            myFrom.clear();
+            myTo.clear();
+        }
+
+        void cLandmarks::build(const cGraph &g, int count)
+        {
+            clear();
+            int V = g.nodeCount();
+            count = std::min(count, V);
+            if (count <= 0)
+                return;
+            myfDirected = g.isDirected();
+            sLinkRows forward = linkRows(g, false);
+
+            // choose landmarks, each farthest from those already chosen
+            std::vector<std::vector<double>> from(count);
+            std::vector<double> minDist(V, INT_MAX);
+            dijkstra(forward, 0, from[0]);
+            int next = std::max_element(from[0].begin(), from[0].end()) - from[0].begin();
+            for (int l = 0; l < count; l++)
+            {
+                myLandmark.push_back(next);
+                dijkstra(forward, next, from[l]);
+                for (int n = 0; n < V; n++)
+                    minDist[n] = std::min(minDist[n], from[l][n]);
+                next = std::max_element(minDist.begin(), minDist.end()) - minDist.begin();
+                if (minDist[next] == 0)
+                    break; // every node is a landmark
+            }
+            count = myLandmark.size();
+            from.resize(count);
+
+            // costs to landmarks, searching back along the links,
+            // by a pool of workers each taking the next landmark not yet searched
+            std::vector<std::vector<double>> to;
+            if (myfDirected)
+            {
+                sLinkRows backward = linkRows(g, true);
+                to.resize(count);
+                std::atomic<int> nextLandmark(0);
+                auto worker = [&]()
+                {
+                    while (1)
+                    {
+                        int l = nextLandmark++;
+                        if (l >= count)
+                            return;
+                        dijkstra(backward, myLandmark[l], to[l]);
+                    }
+                };
+                runWorkers(worker, count);
+            }
+
+            // store as floats, node by node
+            myFrom.resize((size_t)V * count);
+            if (myfDirected)
+                myTo.resize((size_t)V * count);
+            for (int n = 0; n < V; n++)
+                for (int l = 0; l < count; l++)
+                {
+                    myFrom[(size_t)n * count + l] = from[l][n];
+                    if (myfDirected)
+                        myTo[(size_t)n * count + l] = to[l][n];
+                }
+            myNodeCount = V;
+        }
+
+        double cLandmarks::bound(int v, int t) const
+        {
+            // allowance for float rounding, relative to the costs subtracted
+            const double slack = 1.0 / (1 << 22);
+
+            int count = myLandmark.size();
+            const float *fromV = &myFrom[(size_t)v * count];
+            const float *fromT = &myFrom[(size_t)t * count];
+            double best = 0;
+            for (int l = 0; l < count; l++)
+            {
+                if (fromV[l] == unreached || fromT[l] == unreached)
+                    continue;
+                double a = fromT[l], b = fromV[l];
+                double d = myfDirected ? a - b : fabs(a - b);
+                best = std::max(best, d - slack * (a + b));
+            }
+            if (myfDirected)
+            {
+                const float *toV = &myTo[(size_t)v * count];
+                const float *toT = &myTo[(size_t)t * count];
+                for (int l = 0; l < count; l++)
+                {
+                    if (toV[l] == unreached || toT[l] == unreached)
+                        continue;
+                    double a = toV[l], b = toT[l];
+                    best = std::max(best, a - b - slack * (a + b));
+                }
+            }
+            return best;
+        }
+
+        static const char fileMagic[] = "ravenalt1";
+
+        template <class T>
+        static void writeVector(std::ostream &f, const std::vector<T> &v)
+        {
+            int n = v.size();
+            f.write((const char *)&n, sizeof(n));
+            f.write((const char *)v.data(), n * sizeof(T));
+        }
+        template <class T>
+        static void readVector(std::istream &f, std::vector<T> &v)
+        {
+            int n;
+            f.read((char *)&n, sizeof(n));
+            if (!f || n < 0)
+                throw std::runtime_error(
+                    "cLandmarks::read bad file");
+            v.resize(n);
+            f.read((char *)v.data(), n * sizeof(T));
+        }
+
+        void cLandmarks::write(std::ostream &f) const
+        {
+            f.write(fileMagic, sizeof(fileMagic));
+            f.write((const char *)&myNodeCount, sizeof(myNodeCount));
+            char directed = myfDirected;
+            f.write(&directed, 1);
+            writeVector(f, myLandmark);
+            writeVector(f, myFrom);
+            writeVector(f, myTo);
+        }
+
+        void cLandmarks::read(std::istream &f)
+        {
+            clear();
+            char magic[sizeof(fileMagic)];
+            f.read(magic, sizeof(magic));
+            if (!f || memcmp(magic, fileMagic, sizeof(magic)))
+                throw std::runtime_error(
+                    "cLandmarks::read not landmark tables");
+            int V;
+            char directed;
+            f.read((char *)&V, sizeof(V));
+            f.read(&directed, 1);
+            myfDirected = directed;
+            readVector(f, myLandmark);
+            readVector(f, myFrom);
+            readVector(f, myTo);
+            size_t size = (size_t)V * myLandmark.size();
+            if (!f ||
+                myFrom.size() != size ||
+                myTo.size() != (myfDirected ? size : 0))
+            {
+                clear();
+                throw std::runtime_error(
+                    "cLandmarks::read bad file");
+            }
+            myNodeCount = V;
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include <vector>
+#include <iostream>
+#include "cGraph.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief Landmark distances, giving A* a lower bound for graphs without locations
+         *
+         * The cheapest path costs from and to a few landmark nodes are stored for every node.
+         * By the triangle inequality, the cost from v to t is at least
+         * cost( L, t ) - cost( L, v ) and cost( v, L ) - cost( t, L )
+         * for every landmark L.
+         * The best of these bounds guides an A* search towards t, the ALT algorithm.
+         *
+         * Landmarks are chosen one by one, each the node farthest from those already chosen,
+         * so they lie around the edge of the graph where the bounds are tightest.
+         * A node that cannot be reached from the landmarks chosen is farthest of all,
+         * so every part of a graph that is not connected gets a landmark if there are enough.
+         *
+         * The costs are stored as floats, node by node,
+         * so the bounds for one node are together in memory.
+         * The bounds are reduced a little to allow for float rounding,
+         * so they never overestimate.
+         *
+         * Link costs must not be negative.
+         * If the graph changes, the landmarks must be built again.
+         */
+        class cLandmarks
+        {
+        public:
+            cLandmarks()
+                : myNodeCount(0), myfDirected(false)
+            {
+            }
+
+            /** choose landmarks and find path costs from and to them
+             * @param[in] g graph
+             * @param[in] count number of landmarks
+             *
+             * The searches for the costs to the landmarks run in parallel.
+             * Exception thrown if a link cost is negative
+             */
+            void build(const cGraph &g, int count);
+
+            /** lower bound of path cost
+             * @param[in] v node index
+             * @param[in] t node index
+             * @return lower bound of cost from v to t
+             */
+            double bound(int v, int t) const;
+
+            /// number of nodes in graph landmarks were built from, 0 if not built
+            int nodeCount() const
+            {
+                return myNodeCount;
+            }
+
+            /// landmark node indices
+            const std::vector<int> &landmarks() const
+            {
+                return myLandmark;
+            }
+
+            /// write landmark tables to binary stream, so preprocessing need not be repeated
+            void write(std::ostream &f) const;
+
+            /** read landmark tables from binary stream written by write()
+             *
+             * Exception thrown if stream does not contain landmark tables
+             */
+            void read(std::istream &f);
+
+            void clear();
+
+        private:
+            int myNodeCount;
+            bool myfDirected;
+            std::vector<int> myLandmark;
+
+            // path costs, landmark count per node, INT_MAX if no path
+            std::vector<float> myFrom; // from landmark to node
+            std::vector<float> myTo;   // from node to landmark, empty if graph undirected
+        };
+    }
+}
@@ -1,95 +1,98 @@
 #include <fstream>
 #include <vector>
 #include <iostream>
-#include <cstring>
+#include <deque>
+#include <algorithm>
 #include "cMaze.h"
 #include "cPathFinder.h"
 namespace raven
 {
     namespace graph
     {
+        /// read next line, without any trailing carriage return
+        static bool getMazeLine(std::istream &file, std::string &line)
+        {
+            if (!std::getline(file, line))
+                return false;
+            if (line.size() && line.back() == '\r')
+                line.pop_back();
+            return true;
+        }
+
+        /// true if wall character at position in line, missing characters are doorways
+        static bool isMazeWall(const std::string &line, int pos)
+        {
+            if (pos >= (int)line.size())
+                return false;
+            return line[pos] != ' ';
+        }
+
         void cMaze::read(std::ifstream &file)
         {
-            char str1[100], str2[100], str3[100];
-            file.getline(str1, 100);
-            std::string firstline(str1);
-            if (firstline.find("gen") != -1)
+            /* Each row of cells is three lines of text,
+            the last of which is the first line of the next row
+
+            +---+   +    walls above
+            s   |   |    walls left and right, s start
+            +   +---+    walls below
+
+            The rows are read one by one into the packed walls,
+            only three lines of text are stored at any time
+            */
+
+            std::string above, cells, below;
+            if (!getMazeLine(file, above))
+                throw std::runtime_error(
+                    "cMaze::read empty maze");
+            if (above.find("gen") != -1)
             {
-                generate(firstline);
+                generate(above);
                 return;
             }
-            file.getline(str2, 100);
-            file.getline(str3, 100);
-            int line = 1, cell = 1;
-            while (!file.eof())
+            if (above.size() < 5 || above[0] != '+')
+                throw std::runtime_error(
+                    "cMaze::read bad top wall");
+            int cols = (above.size() - 1) / 4;
+
+            while (getMazeLine(file, cells) && getMazeLine(file, below))
             {
-                std::vector<cCell> vCell;
+                if (cells.empty())
+                    break;
 
-                cell = 1;
-                std::cout << "line " << line << std::endl;
-                int i = 0;
-                bool top, down, right, left, start, end;
-                top = down = right = left = false;
-                int j = 0, k = 1;
-                std::cout << "strlen = " << std::strlen(str1) << std::endl;
-                while (i < (int)std::strlen(str1) - 1)
+                addRow(cols);
+                int row = myRowCount - 1;
+                for (int col = 0; col < cols; col++)
                 {
-                    cCell C;
-                    top = down = right = left = start = end = false;
-                    if (str1[i] == '+')
-                        i++; //new cell
-                    if (str1[i] == '-')
-                        top = true;
-                    else if (str1[i] == ' ')
-                        top = false;
-                    i = i + 3; //wall above
-                    if (str2[j] == '|')
-                        left = true;
-                    else if (str2[j] == ' ')
-                        left = false;
-                    else if (str2[j] == 's')
-                    {
-                        left = true;
-                        myStart = cell - 1;
-                    }
-                    j = j + 4; //left wall
-                    if (str2[j] == '|')
-                        right = true;
-                    else if (str2[j] == ' ')
-                        right = false; //right wall
-                    else if (str2[j] == 'e')
-                    {
-                        right = true;
-                        myEnd = cell - 1;
-                    }
-                    if (str3[k] == ' ')
-                        down = false;
-                    else if (str3[k] == '-')
-                        down = true;
-                    k = k + 4; //wall below
-                    //cout << "cell = " << cell << endl;
-                    cell++;
-                    //            cout << "Top :  " << top << "\t";
-                    //            cout << "down :  " << down << endl;
-                    //            cout << "right :  " << right << "\t";
-                    //            cout << "left :  " << left << endl;
-                    //            cout << endl << endl;
-                    C.top = top;
-                    C.down = down;
-                    C.right = right;
-                    C.left = left;
-                    vCell.push_back(C);
+                    int left = 4 * col;
+                    int right = left + 4;
+                    if (left < (int)cells.size() && cells[left] == 's')
+                        myStart = row * cols + col;
+                    if (right < (int)cells.size() && cells[right] == 'e')
+                        myEnd = row * cols + col;
+                    wallRight(row, col, isMazeWall(cells, right));
+                    wallDown(row, col, isMazeWall(below, left + 1));
                 }
-                myMaze.push_back(vCell);
-
-                std::strcpy(str1, str3);
-                std::cout << str1 << std::endl;
-                file.getline(str2, 100);
-                file.getline(str3, 100);
-                std::cout << str2 << std::endl;
-                std::cout << str3 << std::endl;
-                line++;
             }
+            if (!myRowCount)
+                throw std::runtime_error(
+                    "cMaze::read no rows");
+        }
+        void cMaze::size(int rows, int cols)
+        {
+            myRowCount = rows;
+            myColCount = cols;
+            myWall.clear();
+            myWall.resize(((size_t)rows * cols + 3) / 4, 0xFF);
+        }
+        void cMaze::addRow(int cols)
+        {
+            if (!myRowCount)
+                myColCount = cols;
+            else if (cols != myColCount)
+                throw std::runtime_error(
+                    "cMaze::read rows have different lengths");
+            myRowCount++;
+            myWall.resize(((size_t)myRowCount * myColCount + 3) / 4, 0xFF);
         }
         void cMaze::graph(cPathFinder &finder)
         {
@@ -109,11 +112,11 @@ namespace raven
                 for (int col = 0; col < colCount(); col++)
                 {
                     int n = row * colCount() + col;
-                    if (!myMaze[row][col].right)
+                    if (col < colCount() - 1 && !wallRight(row, col))
                     {
                         finder.addLink(n, n + 1);
                     }
-                    if (!myMaze[row][col].down)
+                    if (row < rowCount() - 1 && !wallDown(row, col))
                     {
                         finder.addLink(n, n + colCount());
                     }
@@ -132,6 +135,124 @@ namespace raven
             finder.start("START");
             finder.end("END");
         }
+        std::vector<int> cMaze::path() const
+        {
+            std::vector<int> ret;
+            int V = myRowCount * myColCount;
+            if (0 > myStart || myStart >= V || 0 > myEnd || myEnd >= V)
+                throw std::runtime_error(
+                    "cMaze::path start or end not in maze");
+
+            /* direction from previous cell to each cell
+                0 not reached, 1 right, 2 left, 3 down, 4 up, 5 start
+            */
+            std::vector<unsigned char> pred(V, 0);
+
+            // cells reached, waiting to be searched from
+            std::deque<int> frontier;
+
+            pred[myStart] = 5;
+            frontier.push_back(myStart);
+            while (frontier.size())
+            {
+                int u = frontier.front();
+                frontier.pop_front();
+                if (u == myEnd)
+                    break;
+
+                int row = u / myColCount;
+                int col = u - row * myColCount;
+
+                // doors to neighbouring cells
+                int v;
+                if (col < myColCount - 1 && !wallBit(u, 0))
+                {
+                    v = u + 1;
+                    if (!pred[v])
+                    {
+                        pred[v] = 1;
+                        frontier.push_back(v);
+                    }
+                }
+                if (col > 0 && !wallBit(u - 1, 0))
+                {
+                    v = u - 1;
+                    if (!pred[v])
+                    {
+                        pred[v] = 2;
+                        frontier.push_back(v);
+                    }
+                }
+                if (row < myRowCount - 1 && !wallBit(u, 1))
+                {
+                    v = u + myColCount;
+                    if (!pred[v])
+                    {
+                        pred[v] = 3;
+                        frontier.push_back(v);
+                    }
+                }
+                if (row > 0 && !wallBit(u - myColCount, 1))
+                {
+                    v = u - myColCount;
+                    if (!pred[v])
+                    {
+                        pred[v] = 4;
+                        frontier.push_back(v);
+                    }
+                }
+            }
+
+            if (!pred[myEnd])
+                return ret; // there is no path
+
+            // pick out path, starting at end and finishing at start
+            int v = myEnd;
+            ret.push_back(v);
+            while (pred[v] != 5)
+            {
+                switch (pred[v])
+                {
+                case 1:
+                    v -= 1;
+                    break;
+                case 2:
+                    v += 1;
+                    break;
+                case 3:
+                    v -= myColCount;
+                    break;
+                case 4:
+                    v += myColCount;
+                    break;
+                }
+                ret.push_back(v);
+            }
+            std::reverse(ret.begin(), ret.end());
+
+            return ret;
+        }
+        void cMaze::path(cPathFinder &finder) const
+        {
+            auto vCell = path();
+
+            std::vector<std::string> vName;
+            std::vector<double> vCost;
+            if (vCell.size())
+            {
+                vName.push_back("START");
+                for (int cell : vCell)
+                {
+                    vName.push_back(
+                        finder.orthogonalGridNodeName(
+                            cell / myColCount, cell % myColCount));
+                    vCost.push_back(1);
+                }
+                vName.push_back("END");
+                vCost.push_back(1);
+            }
+            finder.pathNamed(vName, vCost);
+        }
         void cMaze::generate(const std::string &cmd)
         {
             int p = cmd.find("-rows");
@@ -144,6 +265,12 @@ namespace raven
                 throw std::runtime_error(
                     "cMaze::generate cols undefined");
             int cols = atoi(cmd.substr(p + 5).c_str());
+            if (rows < 1 || cols < 1)
+                throw std::runtime_error(
+                    "cMaze::generate bad size");
+            p = cmd.find("-seed");
+            if (p != -1)
+                myRandom.seed(atoll(cmd.substr(p + 5).c_str()));
             p = cmd.find("-file");
             if (p == -1)
                 throw std::runtime_error(
@@ -153,7 +280,7 @@ namespace raven
             if (cmd.find("bin") != -1)
                 generate_binary_tree(rows, cols);
             else if (cmd.find("rec") != -1)
-                generate_recursive_init(rows, cols);
+                generate_recursive(rows, cols);
             else
                 throw std::runtime_error(
                     "cMaze::generate algorithm undefined");
@@ -162,179 +289,146 @@ namespace raven
             throw std::runtime_error(
                     "cMaze::generate cannot open output file");
             f << "format maze\n";
-            for( auto& s : displayText() )
-                f << s << "\n";
+            write(f);
         }
         void cMaze::generate_binary_tree(int row_count, int col_count)
         {
+            size(row_count, col_count);
             for (int row = 0; row < row_count; row++)
             {
-                std::vector<cCell> vCell;
                 for (int col = 0; col < col_count; col++)
                 {
-                    cCell C;
-
                     if (row == 0)
                     {
-                        C.left = false;
+                        wallLeft(row, col, false);
                     }
                     else if (col == 0)
                     {
-                        C.top = false;
+                        wallTop(row, col, false);
                     }
                     else
                     {
-                        int r = rand() % 2;
-                        if (r)
-                            C.left = false;
+                        if (myRandom(2))
+                            wallLeft(row, col, false);
                         else
-                            C.top = false;
+                            wallTop(row, col, false);
                     }
-                    vCell.push_back(C);
                 }
-                myMaze.push_back(vCell);
             }
-            // select random exit
-            if (rand() % 2)
+
+            // every cell connects to the top left
+            myStart = 0;
+
+            // select random exit on the right
+            int row = myRandom(row_count);
+            myEnd = row * col_count + col_count - 1;
+        }
+        void cMaze::generate_recursive(int row_count, int col_count)
+        {
+            // construct initial chamber, maze with no walls except around edges
+            size(row_count, col_count);
+            for (int r = 0; r < row_count; r++)
             {
-                int row = rand() % row_count;
-                myMaze[row][col_count - 1].right = false;
+                for (int c = 0; c < col_count; c++)
+                {
+                    wallRight(r, c, c == col_count - 1);
+                    wallDown(r, c, r == row_count - 1);
+                }
             }
-            else
+
+            // entrance on the left and exit on the right
+            myStart = myRandom(row_count) * col_count;
+            myEnd = myRandom(row_count) * col_count + col_count - 1;
+
+            // chambers waiting to be divided
+            struct sChamber
             {
-                int col = rand() & col_count;
-                myMaze[row_count - 1][col].down = false;
-            }
-        }
-void cMaze::generate_recursive_init(int row_count, int col_count)
-{
-    // construct initial chamber, maze with no walls except around edges
-    for( int r = 0; r < row_count; r++ )
-    {
-        std::vector< cCell > vr;
-        for( int c = 0; c < col_count; c++ )
-        {
-            cCell C( false );
-            if( r == 0 )
-                C.top = true;
-            if( r == row_count-1 )
-                C.down = true;
-            if( c == 0 )
-                C.left = true;
-            if( c == col_count )
-                C.right = true;
-            vr.push_back( C );
-        }
-        myMaze.push_back( vr );
-    }
-    // open entrance and exit in walls around edges
-    int StartRow = rand()%row_count;
-    myStart = StartRow * col_count;
-    int EndRow   = rand()%row_count;
-    myEnd = EndRow * col_count + col_count-1;
+                int x, y, w, h;
+            };
+            std::vector<sChamber> stack;
+            stack.push_back({0, 0, col_count, row_count});
 
-    // myMaze[StartRow][0].left = false;
-    // myMaze[EndRow][col_count].right = false;
+            while (stack.size())
+            {
+                sChamber ch = stack.back();
+                stack.pop_back();
+                int x = ch.x;
+                int y = ch.y;
+                int w = ch.w;
+                int h = ch.h;
 
-    generate_recursive( 0, 0, col_count, row_count );
-}
-void cMaze::generate_recursive( int x, int y, int w, int h )
-{
-    // check for recurion completed
-    if( w == 1 && h == 1 )
-        return;
+                // a chamber one cell wide or high is a corridor, already complete
+                if (w < 2 || h < 2)
+                    continue;
 
-    // raise four walls
-    int newx = w / 2;
-    int newy = h / 2;
-    for( int r = 0; r < h; r++ )
-    {
-        myMaze[y+r][x+newx].left = true;
-    }
-    for( int c = 0; c < w; c++ )
-    {
-        myMaze[y+newy][x+c].top = true;
-    }
-    // open passage in three of four walls
-    int wnop = rand() % 4;
-    if( wnop != 0 )
-        myMaze[y+newy][x+rand() % newx].top = false;
-    if( wnop != 1 )
-        myMaze[y+newy][x+newx+(rand()%(w-newx))].top = false;
-    if( wnop != 2 )
-        myMaze[y+rand()%newy][x+newx].left = false;
-    if( wnop != 3 )
-        myMaze[y+newy+(rand()%(h-newy))][x+newx].left = false;
+                // raise four walls
+                int newx = w / 2;
+                int newy = h / 2;
+                for (int r = 0; r < h; r++)
+                    wallLeft(y + r, x + newx, true);
+                for (int c = 0; c < w; c++)
+                    wallTop(y + newy, x + c, true);
 
-    // recurse into four smaller chambers
-    generate_recursive( x, y, newx, newy );
-    generate_recursive( x + newx, y, w - newx, newy );
-    generate_recursive( x, y + newy, newx, h - newy );
-    generate_recursive( x + newx, y + newy, w - newx, h - newy );
+                // open passage in three of four walls
+                int wnop = myRandom(4);
+                if (wnop != 0)
+                    wallTop(y + newy, x + myRandom(newx), false);
+                if (wnop != 1)
+                    wallTop(y + newy, x + newx + myRandom(w - newx), false);
+                if (wnop != 2)
+                    wallLeft(y + myRandom(newy), x + newx, false);
+                if (wnop != 3)
+                    wallLeft(y + newy + myRandom(h - newy), x + newx, false);
 
-}
-std::vector< std::string > cMaze::displayText()
-{
-    std::cout << myMaze.size() << " rows " << myMaze[0].size() << " cols\n";
-    std::vector< std::string > vss;
-    std::stringstream s1, s2, s3;
-    int kr = 0;
-    for( auto& r : myMaze )
-    {
-        int kc = 0;
-        for( auto& c : r )
+                // divide the four smaller chambers
+                stack.push_back({x, y, newx, newy});
+                stack.push_back({x + newx, y, w - newx, newy});
+                stack.push_back({x, y + newy, newx, h - newy});
+                stack.push_back({x + newx, y + newy, w - newx, h - newy});
+            }
+        }
+        void cMaze::write(std::ostream &f)
         {
-            s1 << "+";
-            if( c.top )
-                s1 << "---";
-            else
-                s1 << "   ";
-            if( c.left )
-                s2 << "|";
-            else
-                s2 << " ";
-            if( onPath(kc,kr))
-                s2 << " * ";
-            else
-                s2 << "   ";
-            if( kc == myMaze[0].size()-1 )
+            std::cout << myRowCount << " rows " << myColCount << " cols\n";
+
+            // one row of text at a time
+            std::string s1, s2;
+            for (int kr = 0; kr < myRowCount; kr++)
             {
-                s1 << "+";
-                if( c.right )
-                    s2 << "|";
+                s1.clear();
+                s2.clear();
+                for (int kc = 0; kc < myColCount; kc++)
+                {
+                    int cell = kr * myColCount + kc;
+                    s1 += '+';
+                    s1 += wallTop(kr, kc) ? "---" : "   ";
+                    if (cell == myStart)
+                        s2 += 's';
+                    else
+                        s2 += wallLeft(kr, kc) ? '|' : ' ';
+                    s2 += onPath(kc, kr) ? " * " : "   ";
+                }
+                s1 += '+';
+                int last = kr * myColCount + myColCount - 1;
+                if (last == myEnd)
+                    s2 += 'e';
                 else
-                    s2 << " ";
+                    s2 += wallRight(kr, myColCount - 1) ? '|' : ' ';
+                f << s1 << "\n"
+                  << s2 << "\n";
             }
-            if( kr == myMaze.size() - 1 )
+
+            // walls below the last row
+            s1.clear();
+            for (int kc = 0; kc < myColCount; kc++)
             {
-                s3 << "+";
-                if( c.down )
-                    s3 << "---";
-                else
-                    s3 << "   ";
-                if( kc == myMaze[0].size()-1 )
-                    s3 << "+";
+                s1 += '+';
+                s1 += wallDown(myRowCount - 1, kc) ? "---" : "   ";
             }
-            kc++;
+            s1 += '+';
+            f << s1 << "\n";
         }
 
-//        cout << s1.str() << "\n";
-//        cout << s2.str() << "\n";
-        vss.push_back( s1.str() );
-        vss.push_back( s2.str() );
-        s1.str("");
-        s2.str("");
-        if( kr == myMaze.size() - 1 )
-        {
-            //cout << s3.str() << "\n";
-            vss.push_back( s3.str() );
-        }
-        kr++;
-    }
-
-    return vss;
-}
-
 
     }
-}
\ No newline at end of file
+}
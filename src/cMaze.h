@@ -1,3 +1,5 @@
+#include "cRandom.h"
+
 namespace raven
 {
     namespace graph
@@ -5,10 +7,25 @@ namespace raven
         // forward definition of class finding paths through graphs
         class cPathFinder;
 
-        /// represents a 2D grid maze
+        /** @brief represents a 2D grid maze
+         *
+         * The walls are packed, 2 bits per cell,
+         * one for the wall on the right of the cell and one for the wall below.
+         * The wall on the left of a cell is the wall on the right of its left neighbour,
+         * the wall above is the wall below its upper neighbour.
+         * The walls around the outside, left and top, are always present.
+         *
+         * Cells are referred to by their index, row * colCount + col
+         */
         class cMaze
         {
         public:
+            cMaze()
+                : myRowCount(0), myColCount(0),
+                  myStart(-1), myEnd(-1)
+            {
+            }
+
             /// read ascii art maze specification
             void read(std::ifstream &file);
 
@@ -17,41 +34,115 @@ namespace raven
              */
             void graph(cPathFinder &finder);
 
+            /** find shortest path from start to end
+             * @return cell indices on path, start first, empty if no path
+             *
+             * Breadth first search directly over the packed walls.
+             */
+            std::vector<int> path() const;
+
+            /** find shortest path from start to end, and store it in finder
+             * @param[out] finder  the path, START -> cells -> END
+             *
+             * Nodes are added only for the cells on the path
+             */
+            void path(cPathFinder &finder) const;
+
             /// get number of rows in maze grid
             int rowCount() const
             {
-                return (int)myMaze.size();
+                return myRowCount;
             }
 
             /// get number of columns in maze grid
             int colCount() const
             {
-                if (!rowCount())
-                    return 0;
-                return (int)myMaze[0].size();
+                return myColCount;
             }
 
-        private:
-            /// represents a single cell in a maze
-            class cCell
+            /// true if wall on right of cell
+            bool wallRight(int row, int col) const
+            {
+                return wallBit(row * myColCount + col, 0);
+            }
+
+            /// true if wall below cell
+            bool wallDown(int row, int col) const
+            {
+                return wallBit(row * myColCount + col, 1);
+            }
+
+            /// true if wall on left of cell
+            bool wallLeft(int row, int col) const
             {
-            public:
-                bool top, down, right, left; ///< true if wall present
+                return col == 0 || wallRight(row, col - 1);
+            }
 
-                /// CTOR - build walls all around cell
-                cCell(bool w = true)
-                    : top(w), down(w), right(w), left(w)
-                {
-                }
-            };
+            /// true if wall above cell
+            bool wallTop(int row, int col) const
+            {
+                return row == 0 || wallDown(row - 1, col);
+            }
+
+        private:
+            int myRowCount;
+            int myColCount;
 
-            /// the maze represented as a 2D vector of calls
-            std::vector<std::vector<cCell>> myMaze;
+            /// walls, 2 bits per cell, 4 cells per byte, row by row
+            std::vector<unsigned char> myWall;
 
             /// 0-based indices of start and end cells
             int myStart, myEnd;
 
-            /// Parse generate command line and run requested generator
+            /// make maze of given size, with every wall present
+            void size(int rows, int cols);
+
+            /// add a row of cells, with every wall present
+            void addRow(int cols);
+
+            bool wallBit(int cell, int bit) const
+            {
+                int shift = 2 * (cell & 3) + bit;
+                return (myWall[cell >> 2] >> shift) & 1;
+            }
+            void wallBit(int cell, int bit, bool f)
+            {
+                int shift = 2 * (cell & 3) + bit;
+                if (f)
+                    myWall[cell >> 2] |= (1 << shift);
+                else
+                    myWall[cell >> 2] &= ~(1 << shift);
+            }
+            void wallRight(int row, int col, bool f)
+            {
+                wallBit(row * myColCount + col, 0, f);
+            }
+            void wallDown(int row, int col, bool f)
+            {
+                wallBit(row * myColCount + col, 1, f);
+            }
+            /// set wall on left of cell, the outside wall cannot be changed
+            void wallLeft(int row, int col, bool f)
+            {
+                if (col > 0)
+                    wallRight(row, col - 1, f);
+            }
+            /// set wall above cell, the outside wall cannot be changed
+            void wallTop(int row, int col, bool f)
+            {
+                if (row > 0)
+                    wallDown(row - 1, col, f);
+            }
+
+            /// random numbers for generators
+            cRandom myRandom;
+
+            /** Parse generate command line and run requested generator
+             *
+             * gen -rows <count> -cols <count> <binary|recursive> [-seed <number>] -file <name>
+             *
+             * The same seed always generates the same maze
+             */
             void generate(const std::string &cmd);
 
             /** Generate maze using binary tree algorithm
@@ -59,15 +150,20 @@ namespace raven
             */
             void generate_binary_tree(int rows, int cols);
 
-            /** Start maze generation using recursive division algorithm
+            /** Generate maze using recursive division algorithm
         https://en.wikipedia.org/wiki/Maze_generation_algorithm#Recursive_division_method
-            */
-            void generate_recursive_init(int rows, int cols);
 
-            /// Recursive division generator
-            void generate_recursive( int x, int y, int w, int h );
+            The chambers waiting to be divided are kept on a stack, rather than by recursion,
+            so large mazes do not overflow the call stack
+            */
+            void generate_recursive(int rows, int cols);
 
-            std::vector< std::string >  displayText();
+            /** write ascii art maze, one row at a time
+             * @param[in] f stream to write to
+             *
+             * The start and end cells are marked with s and e, so the maze can be read back
+             */
+            void write(std::ostream &f);
 
             bool onPath( int r, int c )
             {
@@ -75,4 +171,4 @@ namespace raven
             }
         };
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,19 @@
 #include <sstream>
+#include <cmath>
 #include <algorithm>
 #include <queue>
 #include <set>
 #include <list>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <chrono>
 #include "cPathFinder.h"
+#include "cKDTree.h"
+#include "cDeltaStepping.h"
+#include "cRandom.h"
 #include "cRunWatch.h"
+#include "cWorkers.h"
 
 namespace raven
 {
@@ -17,6 +26,31 @@ namespace raven
             myPath.clear();
             mySource.clear();
             myPathCost = 0;
+            myMetric = eMetric::links;
+            myHierarchy.clear();
+            myLandmarks.clear();
+            myPotential.clear();
+            myReweighted.clear();
+        }
+
+        double cPathFinder::distance(int u, int v) const
+        {
+            double dx = x(u) - x(v);
+            double dy = y(u) - y(v);
+            switch (myMetric)
+            {
+            case eMetric::euclidean:
+                return sqrt(dx * dx + dy * dy);
+            case eMetric::manhattan:
+                return fabs(dx) + fabs(dy);
+            default:
+            {
+                auto it = myG.find(u);
+                if (it == myG.end())
+                    return INT_MAX;
+                return it->second.linkCost(v);
+            }
+            }
         }
 
         bool cPathFinder::isLinkOnPath(const link_t &e) const
@@ -100,13 +134,25 @@ namespace raven
 
             std::stringstream f;
             f << graphvizgraph << " G {\n";
-            for (auto n : nodes())
+            for (auto &n : nodes())
             {
-                auto loc = pickup_node_loc(n.second);
+                std::string color;
+                switch (role(n.first))
+                {
+                case eNodeRole::driver:
+                    color = "blue";
+                    break;
+                case eNodeRole::destination:
+                    color = "red";
+                    break;
+                default:
+                    color = "black";
+                    break;
+                }
                 f << n.second.myName
-                  << " [color=\"" << n.second.myColor
+                  << " [color=\"" << color
                   << "\"  penwidth = 3.0 "
-                  << "pos =\"" << loc.first << "," << loc.second << "!\"];\n";
+                  << "pos =\"" << x(n.first) << "," << y(n.first) << "!\"];\n";
             }
 
             std::cout << "pathViz " << pathText() << "\n";
@@ -222,66 +268,293 @@ namespace raven
             mySource.push_back(s);
         }
 
-        void cPathFinder::path()
+        /// working buffers for short searches, one set for each thread
+        static cPathQuery &threadQuery(const cGraph &g)
         {
-            paths(myStart);
-            pathPick(myEnd);
+            static thread_local cPathQuery query;
+            query.graph(g);
+            return query;
         }
-        void cPathFinder::paths(int start)
+
+        void cPathFinder::path()
         {
-            int V = nodeCount();
+            // preprocessing is no use if the graph has changed since
+            if (myHierarchyVersion != version())
+                myHierarchy.clear();
+            if (myLandmarksVersion != version())
+                myLandmarks.clear();
+
+            if (myHierarchy.nodeCount())
+            {
+                myPathCost = myHierarchy.path(myStart, myEnd, myPath);
+            }
+            else if (myLandmarks.nodeCount())
+            {
+                auto &query = threadQuery(searchGraph());
+                int end = myEnd;
+                query.astar(
+                    myStart, end,
+                    [&](int n)
+                    {
+                        return myLandmarks.bound(n, end);
+                    });
+                myPath = query.path(end);
+                myPathCost = query.dist(end);
+            }
+            else
+            {
+                paths(myStart);
+                pathPick(myEnd);
+                return;
+            }
 
+            // undo reweighting
+            if (myPath.size() && isReweighted())
+                myPathCost += myPotential[myEnd] - myPotential[myStart];
+
+            // only the cost of the whole path is known
             myDist.clear();
-            myDist.resize(V);
-            myPred.clear();
-            myPred.resize(V, -1);
+            if (myPath.size())
+                myDist.push_back(myPathCost);
+        }
 
-            bool sptSet[V]; // sptSet[i] will be true if vertex i is included in shortest
-            // path tree or shortest distance from src to i is finalized
+        void cPathFinder::contract()
+        {
+            myHierarchy.build(searchGraph());
+            myHierarchyVersion = version();
+        }
 
-            // Initialize all distances as INFINITE and stpSet[] as false
-            for (int i = 0; i < V; i++)
-                myDist[i] = INT_MAX, sptSet[i] = false;
+        void cPathFinder::contractWrite(const std::string &fname) const
+        {
+            std::ofstream f(fname, std::ios::binary);
+            if (!f.is_open())
+                throw std::runtime_error(
+                    "cPathFinder::contractWrite cannot open " + fname);
+            myHierarchy.write(f);
+        }
 
-            // Distance of source vertex from itself is always 0
-            myDist[start] = 0;
-            myPred[start] = 0;
+        void cPathFinder::landmarks(int count)
+        {
+            myLandmarks.build(searchGraph(), count);
+            myLandmarksVersion = version();
+        }
+
+        void cPathFinder::landmarksWrite(const std::string &fname) const
+        {
+            std::ofstream f(fname, std::ios::binary);
+            if (!f.is_open())
+                throw std::runtime_error(
+                    "cPathFinder::landmarksWrite cannot open " + fname);
+            myLandmarks.write(f);
+        }
+
+        void cPathFinder::landmarksRead(const std::string &fname)
+        {
+            std::ifstream f(fname, std::ios::binary);
+            if (!f.is_open())
+                throw std::runtime_error(
+                    "cPathFinder::landmarksRead cannot open " + fname);
+            myLandmarks.read(f);
+            if (myLandmarks.nodeCount() != nodeCount())
+            {
+                myLandmarks.clear();
+                throw std::runtime_error(
+                    "cPathFinder::landmarksRead landmarks do not match graph");
+            }
+            myLandmarksVersion = version();
+        }
 
-            // Find shortest path for all vertices
-            for (int count = 0; count < V - 1; count++)
+        void cPathFinder::contractRead(const std::string &fname)
+        {
+            std::ifstream f(fname, std::ios::binary);
+            if (!f.is_open())
+                throw std::runtime_error(
+                    "cPathFinder::contractRead cannot open " + fname);
+            myHierarchy.read(f);
+            if (myHierarchy.nodeCount() != nodeCount())
             {
-                // Pick the minimum distance vertex from the set of vertices not
-                // yet processed. u is always equal to src in the first iteration.
-                int min = INT_MAX, u;
+                myHierarchy.clear();
+                throw std::runtime_error(
+                    "cPathFinder::contractRead hierarchy does not match graph");
+            }
+            myHierarchyVersion = version();
+        }
+        void cPathFinder::paths(int start)
+        {
+            pathsFrom(start, myDist, myPred);
+        }
 
-                for (int v = 0; v < V; v++)
-                    if (sptSet[v] == false && myDist[v] <= min)
-                        min = myDist[v], u = v;
-                if (min == INT_MAX)
+        void cPathFinder::pathsFrom(
+            int start,
+            std::vector<double> &dist,
+            std::vector<int> &pred) const
+        {
+            bool reweighted = isReweighted();
+            cPathQuery query(searchGraph());
+            if (!reweighted && hasNegativeCost())
+                query.bellmanFord({start});
+            else
+            {
+                query.classifyCosts();
+                query.paths(start);
+            }
+
+            int V = nodeCount();
+            dist.resize(V);
+            pred.resize(V);
+            for (int n = 0; n < V; n++)
+            {
+                dist[n] = query.dist(n);
+                pred[n] = query.pred(n);
+
+                // undo reweighting
+                if (reweighted && dist[n] != INT_MAX)
+                    dist[n] += myPotential[n] - myPotential[start];
+            }
+        }
+
+        void cPathFinder::pathsParallel(int start, double delta)
+        {
+            cDeltaStepping search;
+            search.delta(delta);
+            search.paths(searchGraph(), start, myDist, myPred);
+
+            // undo reweighting
+            if (isReweighted())
+                for (int n = 0; n < (int)myDist.size(); n++)
+                    if (myDist[n] != INT_MAX)
+                        myDist[n] += myPotential[n] - myPotential[start];
+        }
+
+        bool cPathFinder::hasNegativeCost() const
+        {
+            // kept for the graph version, so searches that stop early need not look at every link.
+            // Guarded, as this can be called by several threads at once
+            static std::mutex cacheMutex;
+            std::lock_guard<std::mutex> lock(cacheMutex);
+            if (myNegative >= 0 && myNegativeVersion == version())
+                return myNegative;
+
+            myNegative = 0;
+            for (auto &n : myG)
+                for (auto &l : n.second.myLink)
+                    if (l.second.myCost < 0)
+                        myNegative = 1;
+            myNegativeVersion = version();
+            return myNegative;
+        }
+
+        void cPathFinder::makeCostsPositive()
+        {
+            myPotential.clear();
+            myReweighted.clear();
+            int V = nodeCount();
+            if (!V || !hasNegativeCost())
+                return;
+
+            // potentials are the cheapest path costs from a source linked to every node at no cost
+            std::vector<int> all(V);
+            for (int n = 0; n < V; n++)
+                all[n] = n;
+            cPathQuery query(*this);
+            query.bellmanFord(all);
+            myPotential.resize(V);
+            for (int n = 0; n < V; n++)
+                myPotential[n] = query.dist(n);
+
+            // copy of graph with reweighted costs, the link costs of this graph are not changed
+            myReweighted = *this;
+            for (auto &n : myReweighted.nodes())
+                for (auto &l : n.second.myLink)
                 {
-                    // no more nodes connected to start
-                    break;
+                    double &cost = l.second.myCost;
+                    cost += myPotential[n.first] - myPotential[l.first];
+                    if (cost < 0)
+                        cost = 0; // rounding error
                 }
+            myPotentialVersion = version();
 
-                // Mark the picked vertex as processed
-                sptSet[u] = true;
+            // preprocessing of the original costs is no longer used
+            myHierarchy.clear();
+            myLandmarks.clear();
+        }
 
-                // Update dist value of the adjacent vertices of the picked vertex.
-                for (int v : adjacent(u))
+        std::vector<std::pair<int, double>> cPathFinder::costsSorted(int start) const
+        {
+            std::vector<double> dist;
+            std::vector<int> pred;
+            pathsFrom(start, dist, pred);
+            std::vector<std::pair<int, double>> ret;
+            for (int n = 0; n < (int)dist.size(); n++)
+                if (dist[n] != INT_MAX)
+                    ret.push_back(std::make_pair(n, dist[n]));
+            std::stable_sort(
+                ret.begin(), ret.end(),
+                [](const std::pair<int, double> &a, const std::pair<int, double> &b)
                 {
-                    if (sptSet[v])
-                        continue; // already processed
+                    return a.second < b.second;
+                });
+            return ret;
+        }
+
+        bool cPathFinder::isReweighted() const
+        {
+            return myPotential.size() && myPotentialVersion == version();
+        }
+
+        const cGraph &cPathFinder::searchGraph() const
+        {
+            if (isReweighted())
+                return myReweighted;
+            return *this;
+        }
+
+        std::vector<std::pair<int, double>> cPathFinder::within(
+            int start,
+            double radius) const
+        {
+            if (!hasNegativeCost())
+                return threadQuery(*this).within(start, radius);
+
+            // a search cannot stop early, a link beyond the radius might lead back inside
+            auto ret = costsSorted(start);
+            int count = 0;
+            while (count < (int)ret.size() && ret[count].second <= radius)
+                count++;
+            ret.resize(count);
+            return ret;
+        }
 
-                    // Update dist[v] only if total weight of path from src to  v through u is
-                    // smaller than current value of dist[v]
-                    double linkcost = cost(u, v);
-                    if (myDist[u] + linkcost < myDist[v])
+        std::vector<std::pair<int, double>> cPathFinder::nearest(
+            int start,
+            int k,
+            eNodeRole role) const
+        {
+            if (!hasNegativeCost())
+            {
+                if (role == eNodeRole::none)
+                    return threadQuery(*this).nearest(start, k);
+                return threadQuery(*this).nearest(
+                    start, k,
+                    [&](int n)
                     {
-                        myDist[v] = myDist[u] + linkcost;
-                        myPred[v] = u;
-                    }
-                }
+                        return this->role(n) == role;
+                    });
+            }
+
+            // a search cannot stop early, a cheaper path might be found later
+            std::vector<std::pair<int, double>> ret;
+            for (auto &nc : costsSorted(start))
+            {
+                if ((int)ret.size() >= k)
+                    break;
+                if (nc.first == start)
+                    continue;
+                if (role != eNodeRole::none && this->role(nc.first) != role)
+                    continue;
+                ret.push_back(nc);
             }
+            return ret;
         }
 
         std::vector<int> cPathFinder::pathPick(int end)
@@ -324,9 +597,7 @@ namespace raven
                 std::cout << d << " ";
             std::cout << "\n";
             // if (myDist.size() < myPath.back() + 1)
-            myPathCost = myDist[myPath.back()]
-                //    + myMaxNegCost * (myPath.size() - 1)
-                ;
+            myPathCost = myDist[myPath.back()];
             // else
             //     myPathCost = -1;
 
@@ -346,10 +617,11 @@ namespace raven
                 ss << sn << " -> ";
             }
 
-            if (myPath.size() && myDist.size() && myPathCost >= 0)
+            // negative path costs are shown, INT_MAX means there is no cost to show
+            if (myPath.size() && myDist.size() && myPathCost != INT_MAX)
             {
                 ss << " Cost is "
-                   << myPathCost + myMaxNegCost * (myPath.size() - 1)
+                   << myPathCost
                    << "\n";
             }
 
@@ -358,6 +630,11 @@ namespace raven
 
         void cPathFinder::span()
         {
+            if (myMetric != eMetric::links)
+            {
+                spanMetric();
+                return;
+            }
             myPathCost = 0;
             int V = nodeCount();
             std::vector<bool> Q(V, false); // set true when node added to spanning tree
@@ -417,6 +694,87 @@ namespace raven
             }
         }
 
+        void cPathFinder::spanMetric()
+        {
+            /* Prim's algorithm on the complete graph, O(V^2) time and O(V) memory.
+            Links are never stored, the costs are calculated from the locations.
+            Comparing squared euclidean distances gives the same tree, without the square roots
+            */
+            myPathCost = 0;
+            int V = nodeCount();
+            mySpanTree.clear();
+            mySpanTree.copyNodes(*this);
+            if (V < 2)
+                return;
+
+            bool fEuclidean = (myMetric == eMetric::euclidean);
+
+            /* nodes not yet in span, with their locations
+            and the cheapest key connecting them to the span so far,
+            stored in parallel arrays that shrink as nodes are added to the span
+            */
+            std::vector<int> remaining;
+            std::vector<double> rx, ry;
+            std::vector<double> best; // cheapest key connecting node to span
+            std::vector<int> bestFrom; // node in span at other end of cheapest connection
+            for (int v = 1; v < V; v++)
+            {
+                remaining.push_back(v);
+                rx.push_back(x(v));
+                ry.push_back(y(v));
+                best.push_back(INFINITY);
+                bestFrom.push_back(-1);
+            }
+
+            int u = 0;
+            double ux = x(u);
+            double uy = y(u);
+            while (remaining.size())
+            {
+                // update connections to the node most recently added, and find the cheapest
+                int count = remaining.size();
+                int nextPos = 0;
+                for (int kr = 0; kr < count; kr++)
+                {
+                    double dx = rx[kr] - ux;
+                    double dy = ry[kr] - uy;
+                    double k;
+                    if (fEuclidean)
+                        k = dx * dx + dy * dy;
+                    else
+                        k = fabs(dx) + fabs(dy);
+                    if (k < best[kr])
+                    {
+                        best[kr] = k;
+                        bestFrom[kr] = u;
+                    }
+                    if (best[kr] < best[nextPos])
+                        nextPos = kr;
+                }
+
+                // add node to span
+                int next = remaining[nextPos];
+                int from = bestFrom[nextPos];
+                ux = rx[nextPos];
+                uy = ry[nextPos];
+                remaining[nextPos] = remaining.back();
+                rx[nextPos] = rx.back();
+                ry[nextPos] = ry.back();
+                best[nextPos] = best.back();
+                bestFrom[nextPos] = bestFrom.back();
+                remaining.pop_back();
+                rx.pop_back();
+                ry.pop_back();
+                best.pop_back();
+                bestFrom.pop_back();
+
+                double d = distance(from, next);
+                mySpanTree.addLink(from, next, d);
+                myPathCost += d;
+                u = next;
+            }
+        }
+
         std::string cPathFinder::spanText()
         {
             return mySpanTree.linksText();
@@ -426,113 +784,277 @@ namespace raven
             int v,
             std::function<void(int v)> visitor)
         {
-            myPath.clear();
-            myPath.resize(nodeCount(), 0);
-            myPred.clear();
+            cPathQuery(*this).depthFirst(
+                v,
+                [&](int w)
+                {
+                    visitor(w);
+                    return true;
+                });
+        }
+
+        void cPathFinder::breadth(
+            std::function<void(int v, int p)> visitor)
+        {
+            if (!nodeCount())
+                throw std::runtime_error("breadth called on empty graph");
 
-            depthRecurse(v, visitor);
+            cPathQuery(*this).breadth(myStart, visitor);
         }
 
-        void cPathFinder::depthRecurse(
-            int v,
-            std::function<void(int v)> visitor)
+        void cPathFinder::tsp(const std::vector<int> &v)
+        {
+            if (!v.size())
+            {
+                // visit every node
+                tsp();
+                return;
+            }
+            select( v );
+        }
+        void cPathFinder::select( const std::vector<int>& vVisit )
         {
-            // Call the visitor
-            visitor(v);
+            int K = vVisit.size();
+            myPath.clear();
+            myStart = vVisit[0];
+            if (K < 2)
+            {
+                myPath.push_back(myStart);
+                myPathCost = 0;
+                return;
+            }
 
-            // remember this node has been visted
-            myPath[v] = 1;
+            // cost between every pair of selected nodes, and the paths from each
+            std::vector<std::vector<int>> vPred;
+            auto cost = distanceMatrix(vVisit, vVisit, &vPred);
 
-            // look at adjacent nodes
-            for (int w : adjacent(v))
+            // order to visit selected nodes
+            std::vector<int> order;
+            if (K <= 20)
+                order = heldKarp(cost, K);
+            else
             {
+                cPathFinder gSelected;
+                gSelected.makeNodes(K);
+                for (int k1 = 0; k1 < K; k1++)
+                    for (int k2 = k1 + 1; k2 < K; k2++)
+                        gSelected.addLink(k1, k2, cost[k1 * K + k2]);
+                order = gSelected.tsp();
+                order.pop_back();
+            }
+            order.push_back(order[0]);
 
-                // check node has not been visited
-                if (!myPath[w])
+            // cost to reach each selected node from the first
+            myDist.assign(nodeCount(), INT_MAX);
+            for (int k2 = 0; k2 < K; k2++)
+                myDist[vVisit[k2]] = cost[k2];
+
+            // expand tour to every node passed through
+            myPathCost = 0;
+            myPath.push_back(vVisit[order[0]]);
+            for (int k = 1; k < (int)order.size(); k++)
+            {
+                int k1 = order[k - 1];
+                int k2 = order[k];
+                double c = cost[k1 * K + k2];
+                if (c >= INT_MAX)
+                    throw std::runtime_error(
+                        "cPathFinder::select no path between " + userName(vVisit[k1]) + " and " + userName(vVisit[k2]));
+                myPathCost += c;
+                if (myMetric != eMetric::links)
                 {
-                    // continue search from new node
-                    depthRecurse(w, visitor);
+                    myPath.push_back(vVisit[k2]);
+                    continue;
                 }
+                std::vector<int> leg;
+                auto &pred = vPred[k1];
+                for (int n = vVisit[k2]; n != vVisit[k1]; n = pred[n])
+                    leg.push_back(n);
+                myPath.insert(myPath.end(), leg.rbegin(), leg.rend());
             }
+
         }
 
-        void cPathFinder::breadth(
-            std::function<void(int v, int p)> visitor)
+        std::vector<double> cPathFinder::distanceMatrix(
+            const std::vector<int> &vSource,
+            const std::vector<int> &vTarget,
+            std::vector<std::vector<int>> *vPred) const
         {
-            if (!nodeCount())
-                throw std::runtime_error("breadth called on empty graph");
+            int S = vSource.size();
+            int T = vTarget.size();
+            std::vector<double> ret((size_t)S * T);
 
-            std::vector<bool> visited(nodeCount(), false);
-            std::queue<int> Q;
+            if (myMetric != eMetric::links)
+            {
+                // direct route is always cheapest between locations
+                for (int ks = 0; ks < S; ks++)
+                    for (int kt = 0; kt < T; kt++)
+                        ret[(size_t)ks * T + kt] = distance(vSource[ks], vTarget[kt]);
+                return ret;
+            }
+
+            if (vPred)
+            {
+                vPred->clear();
+                vPred->resize(S);
+            }
 
-            visited[myStart] = true;
-            Q.push(myStart);
+            // with negative costs, whole searches by Bellman-Ford or of the reweighted graph
+            bool negative = hasNegativeCost();
 
-            while (Q.size())
+            // pool of workers, each taking the next source not yet searched from
+            std::atomic<int> next(0);
+            auto worker = [&]()
             {
-                int v = Q.front();
-                Q.pop();
-                for (int w : adjacent(v))
+                // working buffers, reused for every search by this worker
+                cPathQuery query(*this);
+                query.classifyCosts();
+                while (1)
                 {
-                    if (!visited[w])
+                    int ks = next++;
+                    if (ks >= S)
+                        return;
+                    if (negative)
                     {
-                        // reached a new node
-                        visitor(w, v);
-                        visited[w] = true;
-                        Q.push(w);
+                        std::vector<double> dist;
+                        std::vector<int> pred;
+                        pathsFrom(vSource[ks], dist, pred);
+                        for (int kt = 0; kt < T; kt++)
+                            ret[(size_t)ks * T + kt] = dist[vTarget[kt]];
+                        if (vPred)
+                            (*vPred)[ks] = pred;
+                        continue;
+                    }
+                    query.paths(vSource[ks], vTarget);
+                    for (int kt = 0; kt < T; kt++)
+                        ret[(size_t)ks * T + kt] = query.dist(vTarget[kt]);
+                    if (vPred)
+                    {
+                        auto &pred = (*vPred)[ks];
+                        pred.resize(nodeCount());
+                        for (int n = 0; n < (int)pred.size(); n++)
+                            pred[n] = query.pred(n);
                     }
                 }
-            }
+            };
+            runWorkers(worker, S);
+
+            return ret;
         }
 
-        void cPathFinder::tsp(const std::vector<int> &v)
+        std::vector<int> cPathFinder::heldKarp(
+            const std::vector<double> &cost,
+            int K)
         {
-            if (!v.size())
+            /* Node 0 is the start.
+            best[ mask * M + j ] is the cheapest path that starts at node 0,
+            visits the nodes in mask, and finishes at node j + 1, which is in mask.
+            Rows for each mask are contiguous, and masks are visited in increasing order,
+            so the smaller masks read have all been calculated
+            */
+            int M = K - 1;
+            int maskCount = 1 << M;
+            std::vector<double> best((size_t)maskCount * M, INFINITY);
+            std::vector<unsigned char> from((size_t)maskCount * M, 0);
+            for (int j = 0; j < M; j++)
+                best[(size_t)(1 << j) * M + j] = cost[j + 1];
+
+            for (int mask = 1; mask < maskCount; mask++)
             {
-                // visit every node
-                tsp();
-                return;
+                double *row = &best[(size_t)mask * M];
+                for (int j = 0; j < M; j++)
+                {
+                    int bit = 1 << j;
+                    if (!(mask & bit) || mask == bit)
+                        continue;
+                    const double *prevRow = &best[(size_t)(mask ^ bit) * M];
+                    double b = INFINITY;
+                    int bf = 0;
+                    for (int i = 0; i < M; i++)
+                    {
+                        if (!((mask ^ bit) & (1 << i)))
+                            continue;
+                        double c = prevRow[i] + cost[(i + 1) * K + j + 1];
+                        if (c < b)
+                        {
+                            b = c;
+                            bf = i;
+                        }
+                    }
+                    row[j] = b;
+                    from[(size_t)mask * M + j] = bf;
+                }
             }
-            select( v );
-        }
-        void cPathFinder::select( const std::vector<int>& vVisit )
-        {
-            cPathFinder gSelected;
-            for( int v : vVisit )
+
+            // cheapest return to start
+            int full = maskCount - 1;
+            int last = 0;
+            double b = INFINITY;
+            for (int j = 0; j < M; j++)
             {
-                gSelected.findoradd(
-                    userName( v ) );
-            }
-            for( int v1 : vVisit ) {
-                myStart = v1;
-                paths( v1 );
-                for( int v2 : vVisit ) {
-                    if( v2 <= v1 )
-                        continue;
-                    pathPick( v2 );
-                    gSelected.addLink(
-                        userName(v1),
-                        userName(v2),
-                        myPathCost );
+                double c = best[(size_t)full * M + j] + cost[(j + 1) * K];
+                if (c < b)
+                {
+                    b = c;
+                    last = j;
                 }
             }
-            std::cout << "select " << gSelected.linksText();
+
+            // pick out tour, from the end back to the start
+            std::vector<int> ret;
+            int mask = full;
+            int j = last;
+            while (mask)
+            {
+                ret.push_back(j + 1);
+                int prev = from[(size_t)mask * M + j];
+                mask ^= 1 << j;
+                j = prev;
+            }
+            ret.push_back(0);
+            std::reverse(ret.begin(), ret.end());
+            return ret;
         }
+
         std::vector<int> cPathFinder::tsp()
         {
 
+            myPath.clear();
+
             // calculate spanning tree
             span();
 
-            // construct pathFinder from spanning tree
-            cPathFinder pf(mySpanTree);
+            /* depth first search of spanning tree, recording nodes in the order first visited
+
+            The search uses an explicit stack, so large trees do not overflow the call stack.
+            Because the spanning tree has no cycles, the order is the same as a recursive search
+            */
+            std::vector<bool> visited(mySpanTree.nodeCount(), false);
+            std::vector<int> stack(1, 0);
+            while (stack.size())
+            {
+                int v = stack.back();
+                stack.pop_back();
+                if (visited[v])
+                    continue;
+                visited[v] = true;
+                myPath.push_back(v);
+                auto adj = mySpanTree.adjacent(v);
+                for (auto it = adj.rbegin(); it != adj.rend(); it++)
+                    if (!visited[*it])
+                        stack.push_back(*it);
+            }
+
+            // shorten tour
+            tspImprove();
 
-            // // depth first search of spanning tree
-            pf.depthFirst(0, [this](int v)
-                          {
-                              // record new node on the search
-                              myPath.push_back(v); });
+            tspClose();
 
+            return myPath;
+        }
+
+        void cPathFinder::tspClose()
+        {
             // return to starting point
             myPath.push_back(myPath[0]);
 
@@ -546,37 +1068,473 @@ namespace raven
                     prev = n;
                     continue;
                 }
-                myPathCost += link(prev, n).myCost;
+                if (myMetric == eMetric::links)
+                    myPathCost += link(prev, n).myCost;
+                else
+                {
+                    // add the links on the path, so they can be displayed
+                    double d = distance(prev, n);
+                    addLink(prev, n, d);
+                    myPathCost += d;
+                }
                 prev = n;
             }
-
-            return myPath;
         }
 
-        void cPathFinder::cams()
+        std::vector<int> cPathFinder::tspMultiStart(int iterations, double seconds)
         {
-            myPath.clear();
+            if (iterations <= 0 && seconds <= 0)
+                throw std::runtime_error(
+                    "cPathFinder::tspMultiStart needs an iteration or time limit");
 
-            // working copy of input graph
-            auto work = *this;
+            myPath.clear();
+            int V = nodeCount();
+            if (V < 2)
+                return myPath;
 
-            // The nodes that connect leaf nodes to the rest of the graph must be in cover set
-            for (int leaf = 0; leaf < nodeCount(); leaf++)
+            // the spanning tree and the candidate links are shared by every iteration
+            span();
+            std::vector<std::vector<int>> tree(V);
+            for (int v = 0; v < V; v++)
+                tree[v] = mySpanTree.adjacent(v);
+            auto cand = nearestNeighbours(8);
+
+            auto deadline = std::chrono::steady_clock::now() +
+                            std::chrono::duration<double>(seconds);
+
+            // best tour so far
+            std::mutex bestMutex;
+            std::atomic<double> bestCost(INFINITY);
+            int bestIteration = -1;
+            std::vector<int> bestTour;
+
+            std::atomic<int> next(0);
+            auto worker = [&]()
             {
-                auto ns = adjacent(leaf);
-                if (ns.size() > 1)
-                    continue;
-
-                // we have a leaf node
-                // get node that connects it
-                // add to cover set
-                int leafcover = *ns.begin();
-                myPath.push_back(leafcover);
-
-                // remove all covered links from working graph
-                for (int t : work.adjacent(leafcover))
+                cRandom random;
+                std::vector<int> tour;
+                std::vector<bool> visited;
+                std::vector<int> stack;
+                while (1)
                 {
-                    work.removeLink(leafcover, t);
+                    int it = next++;
+                    if (iterations > 0 && it >= iterations)
+                        return;
+                    // the first starting tour is always finished, so there is a best tour
+                    if (it && seconds > 0 && std::chrono::steady_clock::now() > deadline)
+                        return;
+                    random.seed(it);
+
+                    // depth first search of spanning tree, random root and child order
+                    int root = 0;
+                    if (it)
+                        root = random(V);
+                    tour.clear();
+                    visited.assign(V, false);
+                    stack.assign(1, root);
+                    while (stack.size())
+                    {
+                        int v = stack.back();
+                        stack.pop_back();
+                        if (visited[v])
+                            continue;
+                        visited[v] = true;
+                        tour.push_back(v);
+                        int first = stack.size();
+                        for (auto kt = tree[v].rbegin(); kt != tree[v].rend(); kt++)
+                            if (!visited[*kt])
+                                stack.push_back(*kt);
+                        if (it)
+                        {
+                            // shuffle children
+                            for (int k = stack.size() - 1; k > first; k--)
+                                std::swap(stack[k], stack[first + random(k - first + 1)]);
+                        }
+                    }
+
+                    tspImprove(tour, cand);
+
+                    double cost = distance(tour.back(), tour[0]);
+                    for (int k = 1; k < (int)tour.size(); k++)
+                        cost += distance(tour[k - 1], tour[k]);
+
+                    // check the shared bound before locking
+                    if (cost > bestCost.load())
+                        continue;
+                    std::lock_guard<std::mutex> lock(bestMutex);
+                    if (cost < bestCost.load() ||
+                        (cost == bestCost.load() && it < bestIteration))
+                    {
+                        bestCost = cost;
+                        bestIteration = it;
+                        bestTour = tour;
+                    }
+                }
+            };
+            runWorkers(worker, iterations > 0 ? iterations : INT_MAX);
+
+            if (!bestTour.size())
+                throw std::runtime_error(
+                    "cPathFinder::tspMultiStart no tour found");
+
+            // tour starting from node 0
+            myPath = bestTour;
+            auto it = std::find(myPath.begin(), myPath.end(), 0);
+            std::rotate(myPath.begin(), it, myPath.end());
+
+            tspClose();
+
+            return myPath;
+        }
+
+        std::vector<std::vector<int>> cPathFinder::nearestNeighbours(int k) const
+        {
+            int V = nodeCount();
+            std::vector<std::vector<int>> ret(V);
+            if (myMetric == eMetric::links)
+            {
+                // the cheapest links from each node
+                for (int v = 0; v < V; v++)
+                {
+                    auto it = myG.find(v);
+                    if (it != myG.end())
+                        for (auto &l : it->second.myLink)
+                            ret[v].push_back(l.first);
+                    std::sort(
+                        ret[v].begin(), ret[v].end(),
+                        [&](int a, int b)
+                        {
+                            return distance(v, a) < distance(v, b);
+                        });
+                    if ((int)ret[v].size() > k)
+                        ret[v].resize(k);
+                }
+                return ret;
+            }
+
+            // the nearest locations to each node
+            std::vector<double> vx, vy;
+            std::vector<int> vid;
+            for (int v = 0; v < V; v++)
+            {
+                vx.push_back(x(v));
+                vy.push_back(y(v));
+                vid.push_back(v);
+            }
+            cKDTree index;
+            index.build(vx, vy, vid);
+            for (int v = 0; v < V; v++)
+            {
+                for (int n : index.nearest(x(v), y(v), k + 1))
+                    if (n != v)
+                        ret[v].push_back(n);
+                if ((int)ret[v].size() > k)
+                    ret[v].resize(k);
+
+                // the tree finds euclidean neighbours, order them by the metric
+                std::stable_sort(
+                    ret[v].begin(), ret[v].end(),
+                    [&](int a, int b)
+                    {
+                        return distance(v, a) < distance(v, b);
+                    });
+            }
+            return ret;
+        }
+
+        void cPathFinder::tspImprove(int neighbours)
+        {
+            if (myPath.size() < 5)
+                return;
+            int start = myPath[0];
+            tspImprove(myPath, nearestNeighbours(neighbours));
+
+            // tour starting from the same node
+            auto it = std::find(myPath.begin(), myPath.end(), start);
+            std::rotate(myPath.begin(), it, myPath.end());
+        }
+
+        void cPathFinder::tspImprove(
+            std::vector<int> &tour,
+            const std::vector<std::vector<int>> &cand) const
+        {
+            const double eps = 1e-9;
+
+            int N = tour.size();
+            if (N < 5)
+                return;
+
+            // position of each node in tour
+            std::vector<int> pos(nodeCount(), -1);
+            for (int k = 0; k < N; k++)
+                pos[tour[k]] = k;
+
+            auto next = [&](int v)
+            {
+                int p = pos[v] + 1;
+                return tour[p == N ? 0 : p];
+            };
+            auto prev = [&](int v)
+            {
+                int p = pos[v] - 1;
+                return tour[p < 0 ? N - 1 : p];
+            };
+
+            /* reverse tour from node from, forwards, to node to
+
+            The tour is a cycle, so reversing the rest of the tour instead gives the same links.
+            The shorter part is reversed.
+            */
+            auto reversePath = [&](int from, int to)
+            {
+                int i = pos[from];
+                int j = pos[to];
+                int len = j - i;
+                if (len < 0)
+                    len += N;
+                len++;
+                if (2 * len > N)
+                {
+                    int ni = j + 1;
+                    int nj = i - 1;
+                    i = (ni == N) ? 0 : ni;
+                    j = (nj < 0) ? N - 1 : nj;
+                    len = N - len;
+                }
+                for (int k = 0; k < len / 2; k++)
+                {
+                    int a = tour[i];
+                    int b = tour[j];
+                    tour[i] = b;
+                    pos[b] = i;
+                    tour[j] = a;
+                    pos[a] = j;
+                    if (++i == N)
+                        i = 0;
+                    if (--j < 0)
+                        j = N - 1;
+                }
+            };
+
+            /* replace links a-b and c-d with links a-c and b-d
+            the links must run in the same direction around the tour
+            */
+            auto move = [&](int a, int b, int c, int d)
+            {
+                if (next(a) == b)
+                    reversePath(b, c);
+                else
+                    reversePath(c, b);
+            };
+
+            // nodes to be looked at, a node drops out when no move improves it
+            std::vector<int> active(tour);
+            std::vector<bool> isActive(nodeCount(), false);
+            for (int v : tour)
+                isActive[v] = true;
+            auto activate = [&](int v)
+            {
+                if (isActive[v])
+                    return;
+                isActive[v] = true;
+                active.push_back(v);
+            };
+
+            /* move segment to between e and c, keeping its direction
+
+            A directed tour cannot be rearranged by reversing parts of it,
+            so it is rebuilt, starting from the node after the segment
+            */
+            auto splice = [&](int s1, int s2, int e)
+            {
+                std::vector<int> rebuilt;
+                rebuilt.reserve(N);
+                for (int v = next(s2); v != s1; v = next(v))
+                {
+                    rebuilt.push_back(v);
+                    if (v == e)
+                        for (int s = s1;; s = next(s))
+                        {
+                            rebuilt.push_back(s);
+                            if (s == s2)
+                                break;
+                        }
+                }
+                tour = rebuilt;
+                for (int k = 0; k < N; k++)
+                    pos[tour[k]] = k;
+            };
+
+            // 2-opt move improving link from a, true if found
+            auto twoOpt = [&](int a)
+            {
+                // reversing part of the tour changes the cost of every link in it
+                if (isDirected())
+                    return false;
+                for (int dir = 0; dir < 2; dir++)
+                {
+                    int b = dir ? prev(a) : next(a);
+                    double dab = distance(a, b);
+                    for (int c : cand[a])
+                    {
+                        double g1 = dab - distance(a, c);
+                        if (g1 <= eps)
+                            break;
+                        int d = dir ? prev(c) : next(c);
+                        if (c == b || d == a)
+                            continue;
+                        if (g1 + distance(c, d) - distance(b, d) <= eps)
+                            continue;
+                        if (dir)
+                            move(b, a, d, c);
+                        else
+                            move(a, b, c, d);
+                        activate(a);
+                        activate(b);
+                        activate(c);
+                        activate(d);
+                        return true;
+                    }
+                }
+                return false;
+            };
+
+            // Or-opt move of 1 to 3 nodes starting at a, true if found
+            auto orOpt = [&](int a)
+            {
+                for (int length = 1; length <= 3 && length + 2 < N; length++)
+                {
+                    int seg[3];
+                    seg[0] = a;
+                    for (int k = 1; k < length; k++)
+                        seg[k] = next(seg[k - 1]);
+                    int s1 = seg[0];
+                    int s2 = seg[length - 1];
+                    auto inSeg = [&](int v)
+                    {
+                        for (int k = 0; k < length; k++)
+                            if (seg[k] == v)
+                                return true;
+                        return false;
+                    };
+                    int p = prev(s1);
+                    int n = next(s2);
+
+                    // saving from removing segment
+                    double g1 = distance(p, s1) + distance(s2, n) - distance(p, n);
+                    if (g1 <= eps)
+                        continue;
+
+                    if (isDirected())
+                    {
+                        // links s2 -> c and e -> s1, where e comes before c
+                        for (int c : cand[s2])
+                        {
+                            double dc = distance(s2, c);
+                            if (dc >= g1)
+                                break;
+                            if (inSeg(c))
+                                continue;
+                            int e = prev(c);
+                            if (inSeg(e))
+                                continue;
+                            if (g1 - (dc + distance(e, s1) - distance(e, c)) <= eps)
+                                continue;
+                            splice(s1, s2, e);
+                            activate(p);
+                            activate(n);
+                            activate(c);
+                            activate(e);
+                            activate(s1);
+                            activate(s2);
+                            return true;
+                        }
+                        continue;
+                    }
+
+                    for (int end = 0; end < 2; end++)
+                    {
+                        int se = end ? s2 : s1;    // segment end to link to c
+                        int other = end ? s1 : s2; // segment end to link to e
+                        for (int c : cand[se])
+                        {
+                            double dc = distance(se, c);
+                            if (dc >= g1)
+                                break;
+                            if (inSeg(c))
+                                continue;
+                            for (int side = 0; side < 2; side++)
+                            {
+                                int e = side ? prev(c) : next(c);
+                                if (inSeg(e))
+                                    continue;
+                                if (g1 - (dc + distance(other, e) - distance(c, e)) <= eps)
+                                    continue;
+
+                                /* insert segment between c and e
+                                by three link exchanges, links in the same direction as p -> s1 */
+                                int cf = side ? e : c; // link cf -> ef
+                                int ef = side ? c : e;
+                                move(p, s1, cf, ef);
+                                move(p, cf, n, s2);
+                                // now cf - s2 and s1 - ef are linked, flip segment if needed
+                                if ((cf == c) != (se == s2))
+                                    move(cf, s2, s1, ef);
+
+                                activate(p);
+                                activate(n);
+                                activate(c);
+                                activate(e);
+                                activate(s1);
+                                activate(s2);
+                                return true;
+                            }
+                        }
+                    }
+                }
+                return false;
+            };
+
+            for (int k = 0; k < (int)active.size(); k++)
+            {
+                int a = active[k];
+                isActive[a] = false;
+                while (twoOpt(a) || orOpt(a))
+                    ;
+                // compact the queue now and then
+                if (k > N && 2 * k > (int)active.size())
+                {
+                    active.erase(active.begin(), active.begin() + k + 1);
+                    k = -1;
+                }
+            }
+
+        }
+
+        void cPathFinder::cams()
+        {
+            myPath.clear();
+
+            // working copy of input graph
+            auto work = *this;
+
+            // The nodes that connect leaf nodes to the rest of the graph must be in cover set
+            for (int leaf = 0; leaf < nodeCount(); leaf++)
+            {
+                auto ns = adjacent(leaf);
+                if (ns.size() > 1)
+                    continue;
+
+                // we have a leaf node
+                // get node that connects it
+                // add to cover set
+                int leafcover = *ns.begin();
+                myPath.push_back(leafcover);
+
+                // remove all covered links from working graph
+                for (int t : work.adjacent(leafcover))
+                {
+                    work.removeLink(leafcover, t);
                 }
             }
 
@@ -616,7 +1574,7 @@ namespace raven
             }
             for (int n : myPath)
                 node(n).myColor = "red";
-            myPathCost = -1;
+            myPathCost = INT_MAX; // nodes found are not a path, so no cost
         }
 
         void cPathFinder::cliques()
@@ -753,6 +1711,7 @@ namespace raven
 
             // restore backup graph
             myG = bkup.graph();
+            changed();
 
             myPathCost = totalFlow;
             myResults = "total flow " + std::to_string(totalFlow);
@@ -790,91 +1749,134 @@ namespace raven
             std::cout << myResults << "\n";
         }
 
-        void cPathFinder::waterValves(
-            const std::vector<int> &valveTimes,
+        int cPathFinder::waterValveWait(
+            int valveTime,
+            int arrival,
             bool pulse)
         {
-            // time that water reaches each node
-            std::vector<int> timeReached(nodeCount(), -1);
+            if (!pulse)
+            {
+                /**    assumes that valve opens at time specified
+                 *     and remains open threafter
+                 */
+                if (valveTime > arrival)
+                    return valveTime - arrival;
+                return 0;
+            }
+
+            /** assumes that valves open instantaneously
+             * every t seconds
+             *
+             * The first opening is at t, so the wait is until
+             * the first multiple of t, at least one, not before arrival
+             */
+            if (valveTime <= 0)
+                return 0;
+            int k = 1;
+            if (arrival > valveTime)
+                k = (arrival + valveTime - 1) / valveTime;
+            return k * valveTime - arrival;
+        }
 
-            std::vector<int> wait(nodeCount(), 0);
+        int cPathFinder::waterFlow(
+            const std::vector<int> &valveTimes,
+            bool pulse,
+            std::vector<int> &timeReached,
+            std::vector<int> &pred) const
+        {
+            /* Time dependent Dijkstra
 
-            myDist.resize(nodeCount(), -1);
+            The arrival time through a valve never decreases
+            when the water arrives at the valve later ( no overtaking )
+            so the first time a node is popped from a queue ordered by arrival time
+            is the earliest time the water can reach it.
 
-            myPred.resize(nodeCount());
+            Only the graph is read, so many schedules can be evaluated
+            at the same time on the same graph.
+            */
 
-            // queue of nodes waiting to be searched from
-            std::queue<int> Q;
+            int V = nodeCount();
+
+            // time that water reaches each node
+            timeReached.clear();
+            timeReached.resize(V, -1);
+
+            pred.clear();
+            pred.resize(V, -1);
+
+            // queue of nodes waiting to be searched from, earliest arrival first
+            typedef std::pair<int, int> arrival_t; // ( time reached, node index )
+            std::priority_queue<
+                arrival_t,
+                std::vector<arrival_t>,
+                std::greater<arrival_t>>
+                Q;
+
+            std::vector<bool> done(V, false);
 
             // start at the start
             timeReached[myStart] = 0;
-            Q.push(myStart);
+            Q.push(std::make_pair(0, myStart));
 
             // loop until all nodes searched from
             while (Q.size())
             {
                 // next node to continue search from
-                int v = Q.front();
+                int Pt = Q.top().first;
+                int v = Q.top().second;
                 Q.pop();
-                int Pt = timeReached[v];
 
-                // std::cout << "search from " << node(v).myName << "\n";
+                // ignore stale queue entries for nodes already reached earlier
+                if (done[v])
+                    continue;
+                done[v] = true;
 
-                // loop over nodes that can be reached from v
-                for (int w : adjacent(v))
-                {
-                    // wait for valve to open
-                    int Wt = 0;
+                // wait for valve to open
+                int Wt = waterValveWait(valveTimes[v], Pt, pulse);
 
-                    if (!pulse)
-                    {
-                        /**    assumes that valve opens at time specified
-                         *     and remains open threafter
-                         */
-                        Wt = valveTimes[v] - Pt;
-                        if (Wt < 0)
-                            Wt = 0;
-                    }
-                    else
-                    {
-                        /** assumes that valves open instantaneously
-                         * every t seconds
-                         */
-                        int t = valveTimes[v];
-                        int k = 1;
-                        while (k * t < Pt)
-                            k++;
-                        Wt = k * t - Pt;
-                    }
+                // loop over pipes leaving v
+                for (auto &l : myG.at(v).myLink)
+                {
+                    int w = l.first;
+                    if (done[w])
+                        continue;
 
                     // time to flow through pipe
-                    int Lt = link(v, w).myCost;
+                    int Lt = l.second.myCost;
 
                     // time to arrive at adjacent node
                     int Vt = Pt + Wt + Lt;
 
-                    // std::cout << "visited " << node(w).myName
-                    //           << " from " << node(v).myName
-                    //           << " " << Pt << " " << Wt << " " << Lt << " " << Vt
-                    //           << " " << timeReached[w] << "\n";
-
                     // if this is later than a previous visit, stop searching
                     if (timeReached[w] > -1)
                         if (Vt >= timeReached[w])
                             continue;
 
-                    // std::cout << "reached " << node(w).myName << "\n";
-
                     // node w reached before any other route
                     timeReached[w] = Vt;
-                    myPred[w] = v;
-                    myDist[w] = Vt;
-                    wait[v] = Wt;
+                    pred[w] = v;
 
                     // continue search from here
-                    Q.push(w);
+                    Q.push(std::make_pair(Vt, w));
                 }
             }
+
+            return timeReached[myEnd];
+        }
+
+        void cPathFinder::waterValves(
+            const std::vector<int> &valveTimes,
+            bool pulse)
+        {
+            std::vector<int> timeReached;
+            waterFlow(valveTimes, pulse, timeReached, myPred);
+
+            myDist.clear();
+            myDist.resize(nodeCount(), -1);
+            for (int n = 0; n < nodeCount(); n++)
+                if (n != myStart)
+                    myDist[n] = timeReached[n];
+
             std::cout
                 << "Water reached " << node(myEnd).myName
                 << " at time " << timeReached[myEnd] << "\n";
@@ -884,10 +1886,73 @@ namespace raven
             std::cout << "node reached at, then waited\n";
             for (int n : myPath)
             {
+                // no need to wait at the end
+                int Wt = 0;
+                if (n != myEnd)
+                    Wt = waterValveWait(valveTimes[n], timeReached[n], pulse);
+
                 std::cout << userName(n) << "\t"
                           << myDist[n] << "\t"
-                          << wait[n] << "\n";
+                          << Wt << "\n";
+            }
+        }
+
+        std::vector<cPathFinder::waterResult_t> cPathFinder::waterSchedules(
+            const std::vector<std::vector<int>> &vSchedule,
+            bool pulse,
+            bool fPath)
+        {
+            std::vector<waterResult_t> ret(vSchedule.size());
+            if (!vSchedule.size())
+                return ret;
+
+            // pool of workers, each taking the next schedule not yet evaluated
+            std::atomic<int> next(0);
+            auto worker = [&]()
+            {
+                std::vector<int> timeReached;
+                std::vector<int> pred;
+                while (1)
+                {
+                    int ks = next++;
+                    if (ks >= (int)vSchedule.size())
+                        return;
+
+                    ret[ks].first = waterFlow(
+                        vSchedule[ks], pulse,
+                        timeReached, pred);
+
+                    if (!fPath || ret[ks].first < 0)
+                        continue;
+
+                    // pick out path, starting at end and finishing at start
+                    auto &path = ret[ks].second;
+                    for (int n = myEnd; n != -1; n = pred[n])
+                        path.push_back(n);
+                    std::reverse(path.begin(), path.end());
+                }
+            };
+            runWorkers(worker, vSchedule.size());
+
+            // Display results
+            std::stringstream ss;
+            for (int ks = 0; ks < (int)ret.size(); ks++)
+            {
+                ss << "schedule " << ks + 1
+                   << " water reached " << userName(myEnd)
+                   << " at time " << ret[ks].first;
+                if (ret[ks].second.size())
+                {
+                    ss << " via ";
+                    for (int n : ret[ks].second)
+                        ss << userName(n) << " ";
+                }
+                ss << "\n";
             }
+            myResults = ss.str();
+            std::cout << myResults;
+
+            return ret;
         }
         void cPathFinder::equiflows()
         {
@@ -947,32 +2012,53 @@ namespace raven
             std::cout << ss.str();
             myResults = ss.str();
         }
-        void cPathFinder::hills(
-            const std::vector<std::vector<float>> &gheight)
+        void cPathFinder::pathNamed(
+            const std::vector<std::string> &vName,
+            const std::vector<double> &vCost)
         {
-
-            // cost links according to change in height they incur
-            int rowCount = gheight.size();
-            if (!rowCount)
+            if (vName.size() && vCost.size() != vName.size() - 1)
                 throw std::runtime_error(
-                    "cPathFinder::hills bad grid");
-            int colCount = gheight[0].size();
+                    "cPathFinder::pathNamed bad cost count");
 
-            for (auto &l : links())
+            clear();
+            myDist.clear();
+            myPathCost = 0;
+            for (int k = 0; k < (int)vName.size(); k++)
             {
-                int source = l.first.first;
-                int target = l.first.second;
-                int srow = source / colCount;
-                int scol = source - srow * colCount;
-                int trow = target / colCount;
-                int tcol = target - trow * colCount;
-                float sh = gheight[srow][scol];
-                float th = gheight[trow][tcol];
-                float delta = th - sh;
-                l.second.myCost = 1 + delta * delta;
+                int n = findoradd(vName[k]);
+                if (k)
+                {
+                    addLink(myPath.back(), n, vCost[k - 1]);
+                    myPathCost += vCost[k - 1];
+                }
+                myPath.push_back(n);
+                myDist.push_back(myPathCost);
             }
+            if (myPath.size())
+            {
+                myStart = myPath.front();
+                myEnd = myPath.back();
+            }
+        }
 
-            path();
+        void cPathFinder::hills(
+            const cGridGraph &grid)
+        {
+            // search the grid, calculating links and their costs as needed
+            auto vCell = grid.path();
+
+            // add named nodes for the cells on the path, and no others
+            std::vector<std::string> vName;
+            std::vector<double> vCost;
+            for (int k = 0; k < (int)vCell.size(); k++)
+            {
+                vName.push_back(
+                    orthogonalGridNodeName(
+                        grid.row(vCell[k]), grid.col(vCell[k])));
+                if (k)
+                    vCost.push_back(grid.cost(vCell[k - 1], vCell[k]));
+            }
+            pathNamed(vName, vCost);
 
             myResults = pathText();
             std::cout << pathText();
@@ -1002,10 +2088,79 @@ namespace raven
                 });
             std::cout << "\n";
         }
+        std::vector<int> cPathFinder::topologicalOrder()
+        {
+            if (!isDirected())
+                throw std::runtime_error(
+                    "cPathFinder::topologicalOrder graph not directed");
+
+            int V = nodeCount();
+
+            // count links into each node
+            std::vector<int> inDegree(V, 0);
+            for (auto &n : nodes())
+                for (auto &l : n.second.myLink)
+                    inDegree[l.first]++;
+
+            // start with the nodes that have no links in
+            std::vector<int> order;
+            order.reserve(V);
+            for (int n = 0; n < V; n++)
+                if (!inDegree[n])
+                    order.push_back(n);
+
+            // add nodes whose links in all come from nodes already ordered
+            for (int k = 0; k < (int)order.size(); k++)
+            {
+                for (auto &l : node(order[k]).myLink)
+                {
+                    if (!--inDegree[l.first])
+                        order.push_back(l.first);
+                }
+            }
+
+            if ((int)order.size() != V)
+                throw std::runtime_error(
+                    "cPathFinder::topologicalOrder graph has a cycle");
+
+            return order;
+        }
+
+        void cPathFinder::dagPaths(int start)
+        {
+            int V = nodeCount();
+
+            myDist.clear();
+            myDist.resize(V, INT_MAX);
+            myPred.clear();
+            myPred.resize(V, -1);
+
+            myDist[start] = 0;
+            myPred[start] = 0;
+
+            // relax the links out of each node in topological order
+            // when a node is reached, all the links into it have been relaxed
+            for (int u : topologicalOrder())
+            {
+                if (myDist[u] == INT_MAX)
+                    continue; // not reachable from start
+
+                for (auto &l : node(u).myLink)
+                {
+                    double d = myDist[u] + l.second.myCost;
+                    if (d < myDist[l.first])
+                    {
+                        myDist[l.first] = d;
+                        myPred[l.first] = u;
+                    }
+                }
+            }
+        }
+
         void cPathFinder::PreReqs(
             const std::vector<std::string> &va)
         {
-            std::set<int> setSkillsNeeded;
+            int V = nodeCount();
 
             // starting node
             start("0");
@@ -1013,36 +2168,81 @@ namespace raven
             // paths to all end nodes
             end(-1);
 
-            // run Dijsktra
-            paths(myStart);
+            // shortest paths through prerequisites, in one topological pass
+            dagPaths(myStart);
+
+            // the skills that lead directly to each skill
+            std::vector<std::vector<int>> vParents(V);
+            for (auto &n : nodes())
+                for (auto &l : n.second.myLink)
+                    vParents[l.first].push_back(n.first);
+
+            /* skills needed, one bit per skill
+
+            The ancestors of each required skill are or-ed in by walking up
+            from the skill, stopping at skills already needed
+            so no skill is visited twice, however many skills are required.
+            */
+            std::vector<bool> skillsNeeded(V, false);
+            std::vector<int> stack;
 
             // loop over required skills
             for (auto &a : va)
             {
+                int skill = find(a);
+                if (skill < 0)
+                    throw std::runtime_error(
+                        "cPathFinder::PreReqs unknown skill " + a);
+
                 // skills needed to get required skill
-                auto path = pathPick(find(a));
+                std::vector<int> path;
+                if (myPred[skill] != -1)
+                {
+                    for (int s = skill; s != myStart; s = myPred[s])
+                        path.push_back(s);
+                    path.push_back(myStart);
+                    std::reverse(path.begin(), path.end());
+                }
 
                 std::cout << "skill " << a << " needs ";
                 for (int s : path)
                     std::cout << userName(s) << " ";
                 std::cout << "\n";
 
-                // loop over prerequsites
-                for (auto s : path)
+                // record all prerequisites not already recorded
+                if (skillsNeeded[skill])
+                    continue;
+                skillsNeeded[skill] = true;
+                stack.push_back(skill);
+                while (stack.size())
                 {
-                    // record skill if not already learned
-                    setSkillsNeeded.insert(s);
+                    int s = stack.back();
+                    stack.pop_back();
+                    for (int p : vParents[s])
+                    {
+                        if (skillsNeeded[p])
+                            continue;
+                        skillsNeeded[p] = true;
+                        stack.push_back(p);
+                    }
                 }
             }
 
-            for (int s : setSkillsNeeded)
+            int countSkillsNeeded = 0;
+            for (int s = 0; s < V; s++)
+            {
+                if (!skillsNeeded[s])
+                    continue;
                 node(s).myColor = "red";
+                countSkillsNeeded++;
+            }
 
             std::stringstream ss;
             ss << "Total skills needed "
-               << setSkillsNeeded.size() << " ( ";
-            for (int s : setSkillsNeeded)
-                ss << userName(s) << " ";
+               << countSkillsNeeded << " ( ";
+            for (int s = 0; s < V; s++)
+                if (skillsNeeded[s])
+                    ss << userName(s) << " ";
             ss << " )";
             myResults = ss.str();
             std::cout << myResults << "\n";
@@ -1050,45 +2250,24 @@ namespace raven
 
         bool cPathFinder::isConnected(
             int node1,
-            int node2)
+            int node2) const
         {
             raven::set::cRunWatch aWatcher("isConnected");
-            try
-            {
-                depthFirst(
-                    node1,
-                    [&](int v)
-                    {
-                        if (v == node2)
-                            throw std::runtime_error("done");
-                    });
-                return false;
-            }
-            catch (std::runtime_error &e)
-            {
-                // std::cout << "catch " << e.what() << "\n";
-                // if (e.what() == "done")
-                return true;
-                // throw e;
-            }
-        }
-        std::pair<double, double> cPathFinder::pickup_node_loc(cNode &n) const
-        {
-#define color_format "%*s %*s %lf %lf"
-            std::pair<double, double> ret;
-            sscanf(
-                n.myColor.c_str(),
-                color_format,
-                &ret.first, &ret.second);
-            return ret;
+
+            // search from node1, stopping when node2 is reached
+            return cPathQuery(*this).depthFirst(
+                node1,
+                [&](int v)
+                {
+                    return v != node2;
+                });
         }
+
         double cPathFinder::pickup_link_cost_pythagorus(
-            cNode &n1, cNode &n2)
+            int n1, int n2) const
         {
-            auto loc1 = pickup_node_loc(n1);
-            auto loc2 = pickup_node_loc(n2);
-            double dx = loc1.first - loc2.first;
-            double dy = loc1.second - loc2.second;
+            double dx = x(n1) - x(n2);
+            double dy = y(n1) - y(n2);
             return sqrt(dx * dx + dy * dy);
         }
         void cPathFinder::pickup()
@@ -1100,141 +2279,389 @@ namespace raven
 
             myResults = "";
 
-            // pythagorean cost of links between all nodes
-            for (auto &mn1 : nodes())
-            {
-                for (auto &mn2 : nodes())
-                {
-                    if (mn2.first <= mn1.first)
-                        continue;
-                    addLink(
-                        mn1.first,
-                        mn2.first,
-                        pickup_link_cost_pythagorus(
-                            mn1.second,
-                            mn2.second));
-                }
-            }
-
             // find driver locations
             std::vector<int> vdriver;
+            std::vector<double> vx, vy;
             int indexdestination = -1;
             for (auto &mn : nodes())
             {
-                auto &color = mn.second.myColor;
-                if (color.find("driver") == 0)
+                switch (role(mn.first))
                 {
+                case eNodeRole::driver:
                     vdriver.push_back(mn.first);
-                }
-                if (color.find("destination") != -1)
+                    vx.push_back(x(mn.first));
+                    vy.push_back(y(mn.first));
+                    break;
+                case eNodeRole::destination:
                     indexdestination = mn.first;
+                    break;
+                default:
+                    break;
+                }
             }
             if (indexdestination == -1)
                 throw std::runtime_error(
                     "cPathFinder::pickup no detination");
 
+            // spatial index of driver locations
+            cKDTree driverIndex;
+            driverIndex.build(vx, vy, vdriver);
+
             // assign cargos to nearest driver
-            struct sassign
-            {
-                int cargo;
-                int driver;
-            };
-            std::vector<sassign> vassign;
+            std::map<int, std::vector<int>> mapDriverCargos;
+            for (int id : vdriver)
+                mapDriverCargos[id];
             for (auto &mcargo : nodes())
             {
-                if (mcargo.second.myColor.find("cargo") == 0)
+                if (role(mcargo.first) != eNodeRole::cargo)
+                    continue;
+                mapDriverCargos[driverIndex.nearest(
+                                    x(mcargo.first),
+                                    y(mcargo.first))]
+                    .push_back(mcargo.first);
+            }
+
+            // drivers with something to pick up
+            std::vector<std::pair<int, std::vector<int>>> vDriverCargos;
+            for (auto &dc : mapDriverCargos)
+                if (dc.second.size())
+                    vDriverCargos.push_back(dc);
+
+            /* route for each driver
+
+            The drivers are independent, so their routes are found in parallel
+            by a pool of workers, each taking the next driver not yet routed
+            */
+            std::vector<std::vector<int>> vRoute(vDriverCargos.size());
+            std::atomic<int> next(0);
+            auto worker = [&]()
+            {
+                while (1)
                 {
-                    double dmin = 1e10;
-                    int nearest = -1;
-                    for (auto &id : vdriver)
+                    int kd = next++;
+                    if (kd >= (int)vDriverCargos.size())
+                        return;
+                    int pgidriver = vDriverCargos[kd].first;
+                    auto &vcargo = vDriverCargos[kd].second;
+
+                    /* create graph with just driver and assigned cargos
+                    driver graph index 0 is the driver,
+                    index k is the cargo at vcargo[k-1]
+                    */
+                    cPathFinder gdriver;
+                    gdriver.makeNodes(vcargo.size() + 1);
+                    for (int dgic1 = 1; dgic1 <= (int)vcargo.size(); dgic1++)
                     {
-                        double d = findLink(id, mcargo.first).myCost;
-                        if (d < dmin)
+                        int pgic1 = vcargo[dgic1 - 1];
+
+                        // add link from driver to cargo
+                        gdriver.addLink(
+                            0,
+                            dgic1,
+                            pickup_link_cost_pythagorus(
+                                pgidriver,
+                                pgic1));
+
+                        // add links from cargo to all other assigned cargos
+                        for (int dgic2 = dgic1 + 1; dgic2 <= (int)vcargo.size(); dgic2++)
                         {
-                            dmin = d;
-                            nearest = id;
+                            gdriver.addLink(
+                                dgic1,
+                                dgic2,
+                                pickup_link_cost_pythagorus(
+                                    pgic1,
+                                    vcargo[dgic2 - 1]));
                         }
                     }
-                    sassign a;
-                    a.cargo = mcargo.first;
-                    a.driver = nearest;
-                    vassign.push_back(a);
+
+                    // solve travelling salesman problem
+                    gdriver.tsp();
+
+                    auto &route = vRoute[kd];
+                    for (int n : gdriver.myPath)
+                    {
+                        if (n == 0)
+                            route.push_back(pgidriver);
+                        else
+                            route.push_back(vcargo[n - 1]);
+                    }
+                    route.back() = indexdestination;
                 }
+            };
+            runWorkers(worker, vDriverCargos.size());
+
+            // display routes in driver order
+            for (auto &route : vRoute)
+            {
+                myPath = route;
+
+                // add the links driven, so they can be displayed
+                for (int k = 1; k < (int)myPath.size(); k++)
+                    addLink(
+                        myPath[k - 1],
+                        myPath[k],
+                        pickup_link_cost_pythagorus(
+                            myPath[k - 1],
+                            myPath[k]));
+
+                myResults += pathText() + "\n\r";
             }
+        }
+        void cPathFinder::pickupCapacity(int neighbours)
+        {
+            myResults = "";
+            myPath.clear();
 
-            // combine all cargos assigned to each driver
-            struct sassign_multi
+            // find drivers, cargos and destination
+            std::vector<int> vdriver;
+            std::vector<int> vcargo;
+            int indexdestination = -1;
+            for (auto &mn : nodes())
+            {
+                switch (role(mn.first))
+                {
+                case eNodeRole::driver:
+                    vdriver.push_back(mn.first);
+                    break;
+                case eNodeRole::cargo:
+                    vcargo.push_back(mn.first);
+                    break;
+                case eNodeRole::destination:
+                    indexdestination = mn.first;
+                    break;
+                default:
+                    break;
+                }
+            }
+            if (indexdestination == -1)
+                throw std::runtime_error(
+                    "cPathFinder::pickupCapacity no destination");
+            if (!vdriver.size())
+                throw std::runtime_error(
+                    "cPathFinder::pickupCapacity no driver");
+            // driver capacities, largest first
+            std::vector<int> vCapacity;
+            for (int d : vdriver)
+                vCapacity.push_back(weight(d));
+            std::sort(vCapacity.begin(), vCapacity.end(), std::greater<int>());
+            int maxCapacity = vCapacity[0];
+
+            // cargos that cannot be given to a driver
+            std::vector<int> vUnassigned;
+
+            // start with a route for each cargo
+            struct sRoute
             {
-                std::vector<int> cargo;
-                int driver;
+                std::deque<int> cargo;
+                int load;
             };
-            std::vector<sassign_multi> vsam;
-            for (auto id : vdriver)
+            std::vector<sRoute> vRoute;
+            std::vector<int> routeOf(nodeCount(), -1);
+            std::vector<double> vx, vy;
+            std::vector<int> vid;
+            for (int c : vcargo)
             {
-                sassign_multi sam;
-                sam.driver = id;
-                for (auto &sa : vassign)
+                if (weight(c) > maxCapacity)
                 {
-                    if (sa.driver != id)
+                    // too big for every vehicle
+                    vUnassigned.push_back(c);
+                    continue;
+                }
+                routeOf[c] = vRoute.size();
+                sRoute r;
+                r.cargo.push_back(c);
+                r.load = weight(c);
+                vRoute.push_back(r);
+                vx.push_back(x(c));
+                vy.push_back(y(c));
+                vid.push_back(c);
+            }
+
+            /* savings from visiting two cargos one after the other
+            instead of returning to the destination between them.
+            Only pairs of near neighbours are considered
+            */
+            cKDTree cargoIndex;
+            cargoIndex.build(vx, vy, vid);
+            std::vector<std::pair<int, int>> vPair;
+            for (int c : vid)
+                for (int n : cargoIndex.nearest(x(c), y(c), neighbours + 1))
+                {
+                    if (n == c)
                         continue;
-                    sam.cargo.push_back(sa.cargo);
+                    vPair.push_back(std::make_pair(std::min(c, n), std::max(c, n)));
                 }
-                vsam.push_back(sam);
+            std::sort(vPair.begin(), vPair.end());
+            vPair.erase(std::unique(vPair.begin(), vPair.end()), vPair.end());
+
+            typedef std::pair<double, std::pair<int, int>> saving_t;
+            std::vector<saving_t> vSaving;
+            for (auto &p : vPair)
+            {
+                double saving =
+                    pickup_link_cost_pythagorus(p.first, indexdestination) +
+                    pickup_link_cost_pythagorus(indexdestination, p.second) -
+                    pickup_link_cost_pythagorus(p.first, p.second);
+                if (saving > 0)
+                    vSaving.push_back(std::make_pair(saving, p));
             }
+            std::sort(vSaving.begin(), vSaving.end(), std::greater<saving_t>());
 
-            // loop over drivers with assigned cargos
-            for (auto &sam : vsam)
+            /* join the cargos of route rSmall onto the end of route rBig
+            where the routes end at cargos u and v
+            */
+            auto join = [&](int rBig, int u, int rSmall, int v)
             {
-                // create graph with just driver and assigned cargos
-                cPathFinder gdriver;
-                int dgidriver = gdriver.findoradd(
-                    findNode(sam.driver).myName);
-                for (auto &ci : sam.cargo)
+                auto &big = vRoute[rBig].cargo;
+                auto &small = vRoute[rSmall].cargo;
+                bool atBack = (big.back() == u);
+                std::vector<int> order(small.begin(), small.end());
+                if (small.front() != v)
+                    std::reverse(order.begin(), order.end());
+                for (int c : order)
                 {
-                    gdriver.findoradd(
-                        findNode(ci).myName);
+                    if (atBack)
+                        big.push_back(c);
+                    else
+                        big.push_front(c);
+                    routeOf[c] = rBig;
                 }
+                vRoute[rBig].load += vRoute[rSmall].load;
+                small.clear();
+                vRoute[rSmall].load = 0;
+            };
 
-                // loop over cargos
-                for (auto &pgic1 : sam.cargo)
-                {
-                    // add link from driver to cargo
-                    gdriver.addLink(
-                        dgidriver,
-                        gdriver.find(userName(pgic1)),
-                        findLink(
-                            sam.driver,
-                            pgic1)
-                            .myCost);
+            /* route loads, heaviest first.
+            The routes can all be given to different drivers
+            if the k-th heaviest route fits the k-th largest vehicle, for every k.
+            When there are more routes than drivers, only the heaviest routes need to fit,
+            the rest must be joined to them, or are left unassigned
+            */
+            std::multiset<int, std::greater<int>> loads;
+            for (auto &r : vRoute)
+                loads.insert(r.load);
+            auto fits = [&]()
+            {
+                auto it = loads.begin();
+                for (int k = 0; k < (int)vCapacity.size() && it != loads.end(); k++, it++)
+                    if (*it > vCapacity[k])
+                        return false;
+                return true;
+            };
 
-                    // add links from cargo to all other assigned cargos
-                    for (auto &pgic2 : sam.cargo)
-                    {
-                        if (pgic2 <= pgic1)
-                            continue;
+            // join routes, largest savings first,
+            // while the routes can still be given to the drivers
+            for (auto &sv : vSaving)
+            {
+                int i = sv.second.first;
+                int j = sv.second.second;
+                int ri = routeOf[i];
+                int rj = routeOf[j];
+                if (ri == rj)
+                    continue;
+                auto &a = vRoute[ri];
+                auto &b = vRoute[rj];
+                if (a.load + b.load > maxCapacity)
+                    continue;
 
-                        gdriver.addLink(
-                            gdriver.find(userName(pgic1)),
-                            gdriver.find(userName(pgic2)),
-                            findLink(
-                                pgic1,
-                                pgic2)
-                                .myCost);
-                    }
+                // cargos inside a route already have both neighbours
+                if (a.cargo.front() != i && a.cargo.back() != i)
+                    continue;
+                if (b.cargo.front() != j && b.cargo.back() != j)
+                    continue;
+
+                // check the joined route leaves a driver for every route that needs one
+                loads.erase(loads.find(a.load));
+                loads.erase(loads.find(b.load));
+                loads.insert(a.load + b.load);
+                if (!fits())
+                {
+                    loads.erase(loads.find(a.load + b.load));
+                    loads.insert(a.load);
+                    loads.insert(b.load);
+                    continue;
                 }
 
-                // solve travelling salesman problem
-                gdriver.tsp();
+                // move the cargos of the shorter route
+                if (a.cargo.size() >= b.cargo.size())
+                    join(ri, i, rj, j);
+                else
+                    join(rj, j, ri, i);
+            }
 
-                myPath.clear();
-                for (auto n : gdriver.myPath)
+            // give routes, heaviest first, to the nearest free driver with enough capacity
+            std::vector<int> vr;
+            for (int r = 0; r < (int)vRoute.size(); r++)
+                if (vRoute[r].cargo.size())
+                    vr.push_back(r);
+            std::stable_sort(
+                vr.begin(), vr.end(),
+                [&](int r1, int r2)
                 {
-                    myPath.push_back(find(gdriver.userName(n)));
+                    return vRoute[r1].load > vRoute[r2].load;
+                });
+            std::vector<bool> driverBusy(vdriver.size(), false);
+            std::map<int, std::vector<int>> mapDriverRoute;
+            for (int r : vr)
+            {
+                auto &route = vRoute[r];
+                int best = -1;
+                double bestDist;
+                bool bestReverse;
+                for (int kd = 0; kd < (int)vdriver.size(); kd++)
+                {
+                    if (driverBusy[kd] || weight(vdriver[kd]) < route.load)
+                        continue;
+                    double df = pickup_link_cost_pythagorus(vdriver[kd], route.cargo.front());
+                    double db = pickup_link_cost_pythagorus(vdriver[kd], route.cargo.back());
+                    if (best == -1 || std::min(df, db) < bestDist)
+                    {
+                        best = kd;
+                        bestDist = std::min(df, db);
+                        bestReverse = db < df;
+                    }
                 }
-                myPath.back() = indexdestination;
+                if (best == -1)
+                {
+                    // no driver left who can carry this route
+                    vUnassigned.insert(vUnassigned.end(), route.cargo.begin(), route.cargo.end());
+                    continue;
+                }
+                driverBusy[best] = true;
+
+                auto &path = mapDriverRoute[vdriver[best]];
+                path.push_back(vdriver[best]);
+                if (bestReverse)
+                    path.insert(path.end(), route.cargo.rbegin(), route.cargo.rend());
+                else
+                    path.insert(path.end(), route.cargo.begin(), route.cargo.end());
+                path.push_back(indexdestination);
+            }
+
+            // display routes in driver order
+            for (auto &dr : mapDriverRoute)
+            {
+                myPath = dr.second;
+
+                // add the links driven, so they can be displayed
+                for (int k = 1; k < (int)myPath.size(); k++)
+                    addLink(
+                        myPath[k - 1],
+                        myPath[k],
+                        pickup_link_cost_pythagorus(
+                            myPath[k - 1],
+                            myPath[k]));
 
                 myResults += pathText() + "\n\r";
             }
+            if (vUnassigned.size())
+            {
+                std::sort(vUnassigned.begin(), vUnassigned.end());
+                myResults += "unassigned";
+                for (int c : vUnassigned)
+                    myResults += " " + userName(c);
+                myResults += "\n\r";
+            }
         }
         void cPathFinder::karup()
         {
@@ -1251,9 +2678,9 @@ namespace raven
                 int value = 0;
                 for (auto a : b.second.myLink)
                 {
-                    value += node(a.first).myCost;
+                    value += weight(a.first);
                 }
-                value *= b.second.myCost;
+                value *= weight(b.first);
                 mapValueNode.insert(std::make_pair(value, b.first));
             }
 
@@ -1281,7 +2708,7 @@ namespace raven
                     {
                         mapNodeValueNode.insert(
                             std::make_pair(
-                                node(nv.second).myCost,
+                                weight(nv.second),
                                 nv.second));
                     }
                     for (auto &nv : mapNodeValueNode)
@@ -1312,7 +2739,7 @@ namespace raven
                         else
                         {
                             // A neighbour remains
-                            value += node(it->first).myCost;
+                            value += weight(it->first);
                             it++;
                         }
                     }
@@ -1340,7 +2767,7 @@ namespace raven
                 {
                     // replace old value with new
                     raven::set::cRunWatch aWatcher("replace");
-                    value *= node(remove).myCost;
+                    value *= weight(remove);
                     mapValueNode.erase(remove_it);
                     mapValueNode.insert(std::make_pair(value, remove));
                 }
@@ -1401,7 +2828,7 @@ namespace raven
 
                     for (int a : adjacent(n.first))
                     {
-                        if (n.second.myCost - node(a).myCost >= 2)
+                        if (weight(n.first) - weight(a) >= 2)
                         {
                             // path must not contain this pair of nodes
                             vforbidden.push_back(std::make_pair(n.first, a));
@@ -1470,6 +2897,7 @@ namespace raven
 
             // restore full path
             myG = backup;
+            changed();
         }
 
         void cPathFinder::srcnuzn_generate()
@@ -1480,14 +2908,14 @@ namespace raven
             clear();
             directed();
             myStart = findoradd("L0");
-            node(myStart).myCost = 0;
+            weight(myStart, 0);
             for (int layer = 1; layer < layerCount - 1; layer++)
             {
                 for (int vl = 0; vl < nodesLayer; vl++)
                 {
                     int n = findoradd(
                         "L" + std::to_string(layer) + "N" + std::to_string(vl));
-                    node(n).myCost = layer;
+                    weight(n, layer);
                     if (layer == 1)
                         addLink(0, n);
                     else
@@ -1502,7 +2930,7 @@ namespace raven
                 }
             }
             myEnd = findoradd("L" + std::to_string(layerCount - 1));
-            node(myEnd).myCost = layerCount;
+            weight(myEnd, layerCount);
             for (int bv = 0; bv < nodesLayer; bv++)
             {
                 addLink(
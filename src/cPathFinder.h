@@ -5,6 +5,10 @@
 #include <map>
 #include <functional>
 #include "cGraph.h"
+#include "cGridGraph.h"
+#include "cPathQuery.h"
+#include "cContractionHierarchy.h"
+#include "cLandmarks.h"
 
 namespace raven
 {
@@ -33,6 +37,16 @@ namespace raven
             srcnuzn,
             pickup,
             allpaths,
+            waterschedules,
+            pickupcapacity,
+        };
+
+        /// how the cost between two nodes is found
+        enum class eMetric
+        {
+            links,     // cost stored in link between the nodes
+            euclidean, // straight line distance between node locations
+            manhattan, // manhattan distance between node locations
         };
 
         /** @brief general purpose path finder
@@ -79,9 +93,15 @@ namespace raven
             /////////////////  Class constructors ///////////////////
 
             cPathFinder()
+                : myMetric(eMetric::links),
+                  myHierarchyVersion(0), myLandmarksVersion(0), myPotentialVersion(0),
+                  myNegative(-1), myNegativeVersion(0)
             {
             }
             cPathFinder(const graph::cGraph &g)
+                : myMetric(eMetric::links),
+                  myHierarchyVersion(0), myLandmarksVersion(0), myPotentialVersion(0),
+                  myNegative(-1), myNegativeVersion(0)
             {
                 myG = g.graph();
                 myfDirected = g.isDirected();
@@ -91,6 +111,26 @@ namespace raven
 
             void clear();
 
+            /** set how the cost between two nodes is found
+             * @param[in] m metric, default links
+             *
+             * With euclidean or manhattan no links need be added,
+             * the cost between any two nodes is calculated from their locations when needed.
+             * This is supported by span(), tsp() and select()
+             */
+            void metric(eMetric m)
+            {
+                myMetric = m;
+            }
+
+            /** cost between two nodes
+             * @param[in] u node index
+             * @param[in] v node index
+             * @return cost, from link or node locations depending on metric.
+             * If metric is links and nodes are not adjacent, returns INT_MAX
+             */
+            double distance(int u, int v) const;
+
             /// starting node
             void start(int start);
             void start(const std::string &start);
@@ -114,13 +154,129 @@ namespace raven
              * The path from attributes myStart to myEnd
              * is saved into myPath
              * The path can be listed by call to pathText()
+             *
+             * If contract() has been called, the contraction hierarchy is used,
+             * otherwise if landmarks() has been called, A* search with landmark bounds.
+             * Either way, the costs to other nodes are not found.
+             * Preprocessing is discarded if the graph has changed since, see cGraph::version().
              */
             void path();
 
+            /** Build contraction hierarchy, so path() can answer many queries quickly
+             *
+             * Preprocessing takes a while, but then each query settles only a few hundred nodes.
+             * Call again if the links are changed, path() does not use a hierarchy of an older graph.
+             * Exception thrown if a link cost is negative.
+             */
+            void contract();
+
+            /// save contraction hierarchy to file, so preprocessing need not be repeated
+            void contractWrite(const std::string &fname) const;
+
+            /** read contraction hierarchy saved by contractWrite()
+             *
+             * Exception thrown if the file is not a hierarchy of a graph with the same node count.
+             * The hierarchy is assumed to be of the graph as it is now.
+             */
+            void contractRead(const std::string &fname);
+
+            /** Choose landmarks, so path() can use A* search on graphs without locations
+             * @param[in] count number of landmarks, more give better bounds but use more memory
+             *
+             * Finds the path costs from and to every landmark, count * node count floats each way.
+             * Call again if the links are changed, path() does not use landmarks of an older graph.
+             * Exception thrown if a link cost is negative.
+             */
+            void landmarks(int count = 16);
+
+            /// save landmark tables to file, so preprocessing need not be repeated
+            void landmarksWrite(const std::string &fname) const;
+
+            /** read landmark tables saved by landmarksWrite()
+             *
+             * Exception thrown if the file is not landmark tables of a graph with the same node count.
+             * The tables are assumed to be of the graph as it is now.
+             */
+            void landmarksRead(const std::string &fname);
+
             /** Find paths from start to all nodes
+             *
+             * If any link cost is negative, Bellman-Ford is used instead of Dijkstra,
+             * with an exception thrown if there is a negative cost cycle.
+             *
+             * Sets myDist and myPred.
+             * To run several searches at once on one graph, use a cPathQuery for each.
              */
             void paths(int start);
 
+            /** Find paths from start to all nodes, searching in parallel by delta-stepping
+             * @param[in] start node index
+             * @param[in] delta bucket width, default chosen from the link costs
+             *
+             * Sets myDist and myPred, as paths( int start ), with the same costs.
+             * Faster than paths() on very large graphs when several cores are free.
+             * Exception thrown if a link cost is negative.
+             */
+            void pathsParallel(
+                int start,
+                double delta = 0);
+
+            /** Nodes that can be reached from start within a cost, an isochrone
+             * @param[in] start node index
+             * @param[in] radius maximum path cost
+             * @return node index and path cost pairs, cheapest first, starting with start
+             *
+             * The search stops at the radius, and reuses working buffers kept by the thread,
+             * so time depends on the number of nodes found, not the size of the graph.
+             * If a link cost is negative, the whole graph is searched, as by paths( int start ),
+             * and nodes can be cheaper than start.
+             */
+            std::vector<std::pair<int, double>> within(
+                int start,
+                double radius) const;
+
+            /** Nearest nodes, by path cost, with a role
+             * @param[in] start node index
+             * @param[in] k number of nodes wanted
+             * @param[in] role of nodes wanted, default any node
+             * @return node index and path cost pairs, cheapest first, not including start
+             *
+             * The search stops when the k-th node is found.
+             * If a link cost is negative, the whole graph is searched, as by paths( int start ).
+             */
+            std::vector<std::pair<int, double>> nearest(
+                int start,
+                int k,
+                eNodeRole role = eNodeRole::none) const;
+
+            /** Make the path a sequence of named nodes, found by some other search
+             * @param[in] vName names of nodes on path, in order
+             * @param[in] vCost cost of each link on path, one less than the number of names
+             *
+             * The graph is cleared, then a node is added for each name
+             * and a link between each pair of consecutive nodes.
+             * Used by searches that do not need the whole graph to be stored.
+             */
+            void pathNamed(
+                const std::vector<std::string> &vName,
+                const std::vector<double> &vCost);
+
+            /** Find paths from start to all nodes in a directed acyclic graph
+             * @param[in] start index of starting node
+             *
+             * One pass over the nodes in topological order, O(V+E).
+             * Sets myDist and myPred, as paths( int start ).
+             * Exception thrown if the graph is undirected or has a cycle.
+             */
+            void dagPaths(int start);
+
+            /** Order nodes so that every link goes from an earlier node to a later node
+             * @return vector of node indices
+             *
+             * Exception thrown if the graph is undirected or has a cycle.
+             */
+            std::vector<int> topologicalOrder();
+
             /** @brief Find path to end node, after call to paths( int start )
              *
              * @param[in] end index of end vertex
@@ -138,20 +294,53 @@ namespace raven
             /// true if two nodes are connected
             bool isConnected(
                 int node1,
-                int node2);
+                int node2) const;
 
             int islandCount();
 
             /// add expensive ( INT_MAX ) links between unlinked nodes
             void makeComplete();
 
-            /** make costs positive
-             * @param[in] cost the maximum negative cost
+            /** make costs positive for searching, keeping the same cheapest paths, by Johnson reweighting
+             *
+             * A potential is found for every node by Bellman-Ford,
+             * and each link cost becomes cost + potential( src ) - potential( dst ),
+             * which is never negative. Every path between two nodes changes cost by the same amount,
+             * so the cheapest paths are unchanged and the faster searches can be used.
+             *
+             * The reweighted costs are kept in a copy of the graph, used only by the searches.
+             * The link costs of this graph are not changed,
+             * and path costs found afterwards are converted back to the original costs.
+             * The copy is not used once the graph changes.
+             *
+             * Call once, before many path queries, on a graph with negative link costs.
+             * Exception thrown if there is a negative cost cycle.
+             */
+            void makeCostsPositive();
+
+            /** true if any link has a negative cost
+             *
+             * Looks at every link only once for each version of the graph
+             */
+            bool hasNegativeCost() const;
+
+            /** Cheapest path costs between many sources and targets
+             * @param[in] vSource source node indices
+             * @param[in] vTarget target node indices
+             * @param[out] vPred if not null, previous node on paths from each source,
+             *    one vector per source, exact for the nodes on the paths to the targets
+             * @return cost from vSource[ks] to vTarget[kt] at [ ks * vTarget.size() + kt ],
+             *    INT_MAX if there is no path
              *
-             * The absolute value of cost will be added to every cost
-             * cost will be saved to to attribute myMaxNegCost
+             * One search per source, run concurrently,
+             * each stopping as soon as the cheapest paths to all targets are known,
+             * or searching the whole graph, as by paths( int start ), if a link cost is negative.
+             * With a location metric the costs are the direct distances, and vPred is not set.
              */
-            void makeCostsPositive(int cost);
+            std::vector<double> distanceMatrix(
+                const std::vector<int> &vSource,
+                const std::vector<int> &vTarget,
+                std::vector<std::vector<int>> *vPred = nullptr) const;
 
             /// Find minimum edge set that connects all nodes together
             void span();
@@ -163,15 +352,40 @@ namespace raven
              */
             void tsp(const std::vector<int> &v);
 
-            /// Find path that visits every node
+            /** Find path that visits every node
+             *
+             * Starts from a depth first search of the minimum spanning tree,
+             * then improves the tour with tspImprove()
+             */
             std::vector<int> tsp();
 
+            /** Find path that visits every node, trying many starting tours
+             * @param[in] iterations number of starting tours, 0 for no limit
+             * @param[in] seconds time allowed, 0 for no limit.
+             *    The first starting tour is always finished, however little time is allowed.
+             * @return best tour found
+             *
+             * Each starting tour is a depth first search of the minimum spanning tree
+             * from a random node, visiting children in random order,
+             * then improved with tspImprove().
+             * The first starting tour is the one used by tsp().
+             *
+             * The starting tours are constructed and improved in parallel.
+             * Iteration k always uses random seed k,
+             * so with no time limit the result does not depend on the number of threads.
+             */
+            std::vector<int> tspMultiStart(int iterations, double seconds = 0);
+
             /// Find nodes that cover all links
             void cams();
 
-            /// Find path in grid that minimizes changes in height
+            /** Find path in grid that minimizes changes in height
+             * @param[in] grid heights, with start and end cells
+             *
+             * Nodes are added only for the cells on the path
+             */
             void hills(
-                const std::vector<std::vector<float>> &gheight);
+                const cGridGraph &grid);
 
             void gsingh();
 
@@ -182,14 +396,40 @@ namespace raven
             void multiflows();
             void equiflows();
 
+            /** Find earliest time water reaches end through pipes with timed valves
+             * @param[in] valveTimes valve timing at each node, by node index
+             * @param[in] pulse true if valves open every valve time, false if they open once and stay open
+             */
             void waterValves(
                 const std::vector<int> &valveTimes,
                 bool pulse);
 
+            /// time water reaches end, and the path it takes
+            typedef std::pair<int, std::vector<int>> waterResult_t;
+
+            /** Evaluate many valve schedules on the same pipe network
+             * @param[in] vSchedule valve timings, one vector of valve times for each schedule
+             * @param[in] pulse true if valves open every valve time, false if they open once and stay open
+             * @param[in] fPath true to return the path for each schedule, default true
+             * @return for each schedule, the time water reaches end ( -1 if never ) and the path
+             *
+             * The schedules are evaluated concurrently, sharing the graph.
+             * A summary is stored in myResults
+             */
+            std::vector<waterResult_t> waterSchedules(
+                const std::vector<std::vector<int>> &vSchedule,
+                bool pulse,
+                bool fPath = true);
+
             /// Find maximal cliques in graph
             void cliques();
 
-            /// Find prerequisites
+            /** Find prerequisites
+             * @param[in] va names of the required skills
+             *
+             * The graph must be directed, from prerequisite to skill,
+             * and acyclic. Every ancestor of a required skill is needed.
+             */
             void PreReqs(
                 const std::vector<std::string> &va);
 
@@ -216,10 +456,25 @@ The output, an ordered vector of node indices, is stored in myPath attribute
             void karup();
 
             void pickup();
+
+            /** Pickup with vehicle capacities and cargo sizes
+             * @param[in] neighbours number of nearest cargos considered for joining to each cargo
+             *
+             * The node weights are the driver capacities and the cargo sizes.
+             *
+             * Routes are built with the Clarke-Wright savings algorithm,
+             * treating the destination as the depot,
+             * joining only cargos that are among each other's nearest neighbours.
+             * Routes are joined only while every route can still be given to a different driver,
+             * so with a mixed fleet the small vehicles get routes that fit them.
+             * The routes are then given, heaviest first, to the nearest free driver with enough capacity.
+             *
+             * Routes, one per line, are stored in myResults,
+             * followed by any cargos that could not be given to a driver.
+             */
+            void pickupCapacity(int neighbours = 20);
             double pickup_link_cost_pythagorus(
-                 cNode &n1, cNode &n2);
-            std::pair<double,double> pickup_node_loc(
-                cNode& n ) const;
+                 int n1, int n2) const;
 
             /**
 We are given a graph of N nodes where each node has exactly 1 directed edge to some node
@@ -320,18 +575,131 @@ We need to answer the queries of type : A, B, which asks time required when 2 ob
             std::vector<double> myDist;  // cost to reach each node from start
             std::vector<int> myPred;  // previous node to each node from start
             graph::cGraph mySpanTree; // minimum spanning tree
+            cContractionHierarchy myHierarchy; // for fast path queries, built by contract()
+            cLandmarks myLandmarks;            // A* bounds for path queries, built by landmarks()
             double myPathCost;        // total cost of links in path
-            int myMaxNegCost;
+            std::vector<double> myPotential; // Johnson potential of each node, empty if costs not reweighted
+            cGraph myReweighted;             // graph with reweighted costs, for searches
             std::string myResults;
+            eMetric myMetric;
+            unsigned myHierarchyVersion; // graph version myHierarchy was built from
+            unsigned myLandmarksVersion; // graph version myLandmarks were built from
+            unsigned myPotentialVersion; // graph version myPotential was found for
+
+            mutable int myNegative;               // 1 if a link cost is negative, 0 if not, -1 not yet known
+            mutable unsigned myNegativeVersion;   // graph version myNegative was found for
+
+            /// true if reweighted costs are of the graph as it is now
+            bool isReweighted() const;
+
+            /** cheapest paths from start to all nodes, with any link costs
+             * @param[in] start node index
+             * @param[out] dist original cost of cheapest path to each node, INT_MAX if none
+             * @param[out] pred previous node on cheapest path to each node
+             *
+             * Bellman-Ford if a link cost is negative, unless the costs have been reweighted.
+             */
+            void pathsFrom(
+                int start,
+                std::vector<double> &dist,
+                std::vector<int> &pred) const;
+
+            /// nodes reachable from start and their path costs, cheapest first, by pathsFrom()
+            std::vector<std::pair<int, double>> costsSorted(int start) const;
+
+            /// graph with costs that are not negative, if reweighted, otherwise this graph
+            const cGraph &searchGraph() const;
+
+            /// minimum spanning tree of complete graph with costs from node locations
+            void spanMetric();
+
+            /** Improve tour in myPath by local search
+             * @param[in] neighbours number of nearest nodes considered for new links to each node
+             *
+             * Repeats 2-opt moves ( reverse part of the tour )
+             * and Or-opt moves ( move 1 to 3 consecutive nodes elsewhere )
+             * until no move shortens the tour.
+             * Only moves that link a node to one of its nearest neighbours are tried,
+             * and a node is not looked at again until one of its links changes,
+             * so each pass takes close to linear time.
+             *
+             * In a directed graph the cost of a link can depend on its direction,
+             * so 2-opt moves and Or-opt moves that reverse the moved nodes are not tried.
+             * The moved nodes keep their order, and the tour is rebuilt for each move.
+             */
+            void tspImprove(int neighbours = 8);
+
+            /** Improve tour by local search
+             * @param[in,out] tour node indices, without return to start
+             * @param[in] cand candidate nodes for new links to each node, nearest first
+             *
+             * Does not change any attributes, so can run concurrently
+             */
+            void tspImprove(
+                std::vector<int> &tour,
+                const std::vector<std::vector<int>> &cand) const;
+
+            /// candidate nodes for new links, nearest first
+            std::vector<std::vector<int>> nearestNeighbours(int k) const;
 
-            void depthRecurse(int v, std::function<void(int v)> visitor);
+            /** close the tour in myPath, calculate its cost
+             *
+             * If the costs are calculated from locations, the links on the tour are added
+             */
+            void tspClose();
 
             /** Breadth First Search
              * @param[in] visitor function to call on each new node visited
              */
             void breadth(std::function<void(int v, int p)> visitor);
 
+            /** Find tour that visits selected nodes, returning to the first
+             * @param[in] v indices of nodes to visit
+             *
+             * The cheapest path between every pair of selected nodes is found,
+             * one Dijkstra search per selected node, in parallel.
+             * Up to 20 selected nodes, the tour is exact, using Held-Karp dynamic programming.
+             * For more, the tour is found by tsp() on the graph of selected nodes.
+             *
+             * The tour, expanded to every node passed through, is stored in myPath.
+             * Memory is proportional to selected node count times graph node count.
+             */
             void select( const std::vector<int>& v );
+
+            /** Exact cheapest tour with Held-Karp dynamic programming
+             * @param[in] cost cost between each pair of K nodes, row by row
+             * @param[in] K number of nodes
+             * @return node order, starting with 0, without the return to 0
+             */
+            static std::vector<int> heldKarp(
+                const std::vector<double> &cost,
+                int K);
+
+            /** Time dependent search of pipes with timed valves
+             * @param[in] valveTimes valve timing at each node
+             * @param[in] pulse true if valves open every valve time
+             * @param[out] timeReached time water reaches each node, -1 if never
+             * @param[out] pred previous node on path to each node
+             * @return time water reaches end node
+             *
+             * Does not change any attributes, so can run concurrently
+             */
+            int waterFlow(
+                const std::vector<int> &valveTimes,
+                bool pulse,
+                std::vector<int> &timeReached,
+                std::vector<int> &pred) const;
+
+            /** Time spent waiting for a valve to open
+             * @param[in] valveTime valve timing
+             * @param[in] arrival time water arrives at valve
+             * @param[in] pulse true if valve opens every valveTime
+             * @return wait time
+             */
+            static int waterValveWait(
+                int valveTime,
+                int arrival,
+                bool pulse);
         };
     }
 }
@@ -32,6 +32,13 @@ namespace raven
                 std::cout << myFinder.pathText() << "\n";
                 return eCalculation::costs;
             }
+            else if (line.find("water") != -1 && line.find("schedules") != -1)
+            {
+                bool pulse;
+                auto vSchedule = valveSchedules(pulse);
+                myFinder.waterSchedules(vSchedule, pulse);
+                return eCalculation::waterschedules;
+            }
             else if (line.find("water") != -1)
             {
                 bool pulse;
@@ -50,7 +57,24 @@ namespace raven
             else if (line.find("sales") != -1)
             {
                 raven::set::cRunWatch::Start();
-                myFinder.tsp(sales());
+                auto visit = sales();
+                if (line.find("multistart") != -1 && !visit.size())
+                {
+                    // format sales multistart [-iterations <count>] [-seconds <time>]
+                    int iterations = 0;
+                    double seconds = 0;
+                    int p = line.find("-iterations");
+                    if (p != -1)
+                        iterations = atoi(line.substr(p + 11).c_str());
+                    p = line.find("-seconds");
+                    if (p != -1)
+                        seconds = atof(line.substr(p + 8).c_str());
+                    if (iterations <= 0 && seconds <= 0)
+                        iterations = 16;
+                    myFinder.tspMultiStart(iterations, seconds);
+                }
+                else
+                    myFinder.tsp(visit);
                 raven::set::cRunWatch::Report();
                 return eCalculation::sales;
             }
@@ -85,7 +109,10 @@ namespace raven
             }
             else if (line.find("hills") != -1)
             {
-                myFinder.hills(orthogonalGrid());
+                auto grid = orthogonalGrid();
+                if (line.find("diagonal") != -1)
+                    grid.diagonal();
+                myFinder.hills(grid);
                 return eCalculation::hills;
             }
             else if (line.find("prerequisites") != -1)
@@ -138,8 +165,7 @@ namespace raven
             {
                 cMaze maze;
                 maze.read(myFile);
-                maze.graph(myFinder);
-                myFinder.path();
+                maze.path(myFinder);
                 myFormat = eCalculation::costs;
             }
             else if (line.find("allpaths") != -1)
@@ -165,6 +191,8 @@ namespace raven
             else if (line.find("pickup") != -1)
             {
                 pickup();
+                if (line.find("capacity") != -1)
+                    return eCalculation::pickupcapacity;
                 return eCalculation::pickup;
             }
             else if (line.find("polygon") != -1)
@@ -205,8 +233,8 @@ namespace raven
             myFinder.clear();
             if (directed)
                 myFinder.directed();
-            int cost;
-            int maxNegCost = 0;
+            double cost;
+            bool negative = false;
             std::string line;
             while (std::getline(myFile, line))
             {
@@ -231,8 +259,8 @@ namespace raven
                         cost = atof(token[3].c_str());
                     else
                         cost = 1;
-                    if (cost < maxNegCost)
-                        maxNegCost = cost;
+                    if (cost < 0)
+                        negative = true;
                     myFinder.addLink(
                         token[1],
                         token[2],
@@ -255,12 +283,9 @@ namespace raven
                     break;
                 }
             }
-            if (maxNegCost < 0)
-            {
+            if (negative)
                 std::cout << "Negative link costs present\n"
-                          << "Adding positive offset to all link costs\n";
-                //        myFinder.makeCostsPositive(maxNegCost);
-            }
+                          << "Paths will be found by Bellman-Ford\n";
 
             // std::cout << "<-costs\n" <<myFinder.linksText() << "\n";
         }
@@ -291,7 +316,7 @@ namespace raven
                 case 'n':
                     if (token.size() != 3)
                         throw std::runtime_error("cPathFinder::read bad node line");
-                    myFinder.findNode(myFinder.findoradd(token[1])).myCost = atoi(token[2].c_str());
+                    myFinder.weight(myFinder.findoradd(token[1]), atoi(token[2].c_str()));
                     break;
 
                 case 'l':
@@ -343,11 +368,10 @@ namespace raven
                 ss >> token;
                 if( token == "v") {
                     ss >> token;
-                    auto& n = myFinder.findNode( myFinder.findoradd( token ) );
-                    ss >> token;
-                    std::string color = token;
-                    ss >> token;
-                    n.myColor = color + " " + token;
+                    int n = myFinder.findoradd( token );
+                    double x, y;
+                    ss >> x >> y;
+                    myFinder.location( n, x, y );
                 }
                 else if( token == "e") {
                     std::string v1, v2;
@@ -371,23 +395,34 @@ namespace raven
                 auto token = ParseSpaceDelimited(line);
                 if (!token.size())
                     continue;
-                std::string nodeType;
+                if (token.size() != 4 && token.size() != 5)
+                    throw std::runtime_error(
+                        "Invalid pickup input - bad line");
+                eNodeRole role = eNodeRole::none;
                 switch (token[0][0])
                 {
                 case 'd':
-                    nodeType = "driver";
+                    role = eNodeRole::driver;
                     fd = true;
                     break;
                 case 'c':
-                    nodeType = "cargo";
+                    role = eNodeRole::cargo;
                     break;
                 case 'e':
-                    nodeType = "destination";
+                    role = eNodeRole::destination;
                     fe = true;
                     break;
                 }
-                myFinder.findNode(myFinder.findoradd(token[3])).myColor =
-                    nodeType + " at " + token[1] + " " + token[2];
+                int n = myFinder.findoradd(token[3]);
+                myFinder.role(n, role);
+                myFinder.location(
+                    n,
+                    atof(token[1].c_str()),
+                    atof(token[2].c_str()));
+
+                // optional driver capacity or cargo size
+                if (token.size() == 5)
+                    myFinder.weight(n, atoi(token[4].c_str()));
             }
             if (!fd)
                 throw std::runtime_error(
@@ -400,7 +435,18 @@ namespace raven
         std::vector<int> cPathFinderReader::valves(
             bool &pulse)
         {
-            std::vector<int> valveTimes;
+            auto vSchedule = valveSchedules(pulse);
+            if (!vSchedule.size())
+                return std::vector<int>();
+
+            // the last valve timings specified are used
+            return vSchedule.back();
+        }
+
+        std::vector<std::vector<int>> cPathFinderReader::valveSchedules(
+            bool &pulse)
+        {
+            std::vector<std::vector<int>> vSchedule;
             myFinder.clear();
 
             int cost;
@@ -422,7 +468,7 @@ namespace raven
 
                 case 'l':
                     // link
-                    if (valveTimes.size())
+                    if (vSchedule.size())
                         throw std::runtime_error("cPathFinder::read valve times must be after pipe specs");
                     if (token.size() != 4)
                         throw std::runtime_error("cPathFinder::read bad link line");
@@ -453,22 +499,29 @@ namespace raven
                     break;
 
                 case 't':
+                {
                     // valve timings
                     if (token.size() < 2)
                         throw std::runtime_error("cPathFinder::read bad time line");
                     token.erase(token.begin());
+                    bool linePulse;
                     if (token[0][0] == 'p')
-                        pulse = true;
+                        linePulse = true;
                     else if (token[0][0] == 'a')
-                        pulse = false;
+                        linePulse = false;
                     else
                         throw std::runtime_error("cPathFinder::read valve times must specify 'pulse' or 'always'");
+                    if (vSchedule.size() && linePulse != pulse)
+                        throw std::runtime_error("cPathFinder::read valve schedules must all be 'pulse' or all 'always'");
+                    pulse = linePulse;
                     token.erase(token.begin());
-                    valveTimes.resize(myFinder.nodeCount());
+                    std::vector<int> valveTimes(myFinder.nodeCount());
                     int nodeIndex = 1;
                     for (auto &s : token)
                         valveTimes[myFinder.find(std::to_string(nodeIndex++))] = atoi(s.c_str());
-                    break;
+                    vSchedule.push_back(valveTimes);
+                }
+                break;
                 }
             }
             if (maxNegCost < 0)
@@ -480,7 +533,7 @@ namespace raven
 
             // std::cout << "<-costs\n" <<myFinder.linksText() << "\n";
 
-            return valveTimes;
+            return vSchedule;
         }
 
         void cPathFinderReader::links()
@@ -536,7 +589,7 @@ namespace raven
                     if (token.size() != 3)
                         throw std::runtime_error(
                             "bad node line");
-                    myFinder.node(myFinder.findoradd(token[1])).myCost = atoi(token[2].c_str());
+                    myFinder.weight(myFinder.findoradd(token[1]), atoi(token[2].c_str()));
                     break;
                 case 'l':
                     if (token.size() != 3)
@@ -599,15 +652,6 @@ namespace raven
 
         std::vector<int> cPathFinderReader::sales()
         {
-            struct sCity
-            {
-                int x;
-                int y;
-                std::string name;
-            };
-            std::vector<sCity> vCity;
-            sCity city;
-
             std::vector<int> visit;
 
             enum class eInput
@@ -640,10 +684,10 @@ namespace raven
                         input = eInput::city;
                     else if (input != eInput::city && input != eInput::manhatten)
                         throw std::runtime_error("Mixed input formats");
-                    city.x = atoi(token[1].c_str());
-                    city.y = atoi(token[2].c_str());
-                    city.name = token[3];
-                    vCity.push_back(city);
+                    myFinder.location(
+                        myFinder.findoradd(token[3]),
+                        atoi(token[1].c_str()),
+                        atoi(token[2].c_str()));
                     break;
                 case 'l':
                     if (input == eInput::unknown)
@@ -673,49 +717,18 @@ namespace raven
                 }
             }
 
+            /* cities are not linked,
+            the distance between them is calculated when needed from their locations
+            */
             switch (input)
             {
             case eInput::city:
-            {
-                // link all the cities by the pythagorian distance between them
-                for (int c1 = 0; c1 < vCity.size(); c1++)
-                {
-                    for (int c2 = c1 + 1; c2 < vCity.size(); c2++)
-                    {
-                        float dx = vCity[c1].x - vCity[c2].x;
-                        float dy = vCity[c1].y - vCity[c2].y;
-                        float d = sqrt(dx * dx + dy * dy);
-                        // std::cout << vCity[c1].name << " " << vCity[c2].name << " "
-                        //           << dx << " " << dy << " " << d << "\n";
-                        myFinder.addLink(
-                            vCity[c1].name,
-                            vCity[c2].name,
-                            d);
-                    }
-                }
-            }
-            break;
+                myFinder.metric(eMetric::euclidean);
+                break;
 
             case eInput::manhatten:
-            {
-                raven::set::cRunWatch aWatcher("CalculateManhattenDistances");
-                for (int c1 = 0; c1 < vCity.size(); c1++)
-                {
-                    for (int c2 = 0; c2 < vCity.size(); c2++)
-                    {
-                        if (vCity[c1].name == vCity[c2].name)
-                            continue;
-                        // manhatten distance
-                        float d =
-                            fabs(vCity[c1].x - vCity[c2].x) + fabs(vCity[c1].y - vCity[c2].y);
-                        myFinder.addLink(
-                            vCity[c2].name,
-                            vCity[c1].name,
-                            d);
-                    }
-                }
-            }
-            break;
+                myFinder.metric(eMetric::manhattan);
+                break;
 
             default:
             {
@@ -727,22 +740,20 @@ namespace raven
 
             return visit;
         }
-        std::vector<std::vector<float>> cPathFinderReader::orthogonalGrid()
+        cGridGraph cPathFinderReader::orthogonalGrid()
         {
             if (!myFile.is_open())
                 throw std::runtime_error(
                     "cPathFinderReader::orthogonalGrid file not open");
 
-            const bool fDirected = true;
-
             myFinder.clear();
-            myFinder.directed(fDirected);
 
-            std::vector<std::vector<float>> grid;
+            cGridGraph grid;
+            std::vector<float> height;
             int RowCount = 0;
             int ColCount = -1;
-            int start = -1;
-            int end = -1;
+            int startRow = -1, startCol = -1;
+            int endRow = -1, endCol = -1;
             std::string line;
             while (std::getline(myFile, line))
             {
@@ -758,10 +769,9 @@ namespace raven
                         ColCount = token.size() - 1;
                     else if (token.size() - 1 != ColCount)
                         throw std::runtime_error("Bad column count");
-                    std::vector<float> row;
                     for (int k = 1; k < token.size(); k++)
-                        row.push_back(atof(token[k].c_str()));
-                    grid.push_back(row);
+                        height.push_back(atof(token[k].c_str()));
+                    RowCount++;
                 }
                 break;
                 case 's':
@@ -769,72 +779,30 @@ namespace raven
                         throw std::runtime_error("Bad start");
                     if (ColCount == -1)
                         throw std::runtime_error("Start node must be at end");
-                    start =
-                        (atoi(token[2].c_str()) - 1) * ColCount + atoi(token[1].c_str()) - 1;
+                    startCol = atoi(token[1].c_str()) - 1;
+                    startRow = atoi(token[2].c_str()) - 1;
                     break;
                 case 'e':
                     if (token.size() != 3)
                         throw std::runtime_error("Bad end");
                     if (ColCount == -1)
                         throw std::runtime_error("End node must be at end");
-                    end =
-                        (atoi(token[2].c_str()) - 1) * ColCount + atoi(token[1].c_str()) - 1;
+                    endCol = atoi(token[1].c_str()) - 1;
+                    endRow = atoi(token[2].c_str()) - 1;
                     break;
                 }
             }
-            RowCount = grid.size();
-            // std::cout << "<-cHillPathFinder::read " << myRowCount << "\n";
 
-            // add nodes at each grid cell
-            for (int row = 0; row < RowCount; row++)
-            {
-                for (int col = 0; col < ColCount; col++)
-                {
-                    int n = myFinder.findoradd(
-                        myFinder.orthogonalGridNodeName(row, col));
-                }
-            }
-            myFinder.start(start);
-            myFinder.end(end);
-
-            // link cells orthogonally
-            for (int row = 0; row < RowCount; row++)
-                for (int col = 0; col < ColCount; col++)
-                {
-                    int n = row * ColCount + col;
+            grid.heights(RowCount, ColCount, height);
+            grid.start(startRow, startCol);
+            grid.end(endRow, endCol);
 
-                    if (fDirected)
-                    {
-                        if (col > 0)
-                        {
-                            int left = row * ColCount + col - 1;
-                            myFinder.addLink(n, left, 1);
-                        }
-                    }
-                    if (col < ColCount - 1)
-                    {
-                        int right = row * ColCount + col + 1;
-                        myFinder.addLink(n, right, 1);
-                    }
-                    if (fDirected)
-                    {
-                        if (row > 0)
-                        {
-                            int up = (row - 1) * ColCount + col;
-                            myFinder.addLink(n, up, 1);
-                        }
-                    }
-                    if (row < RowCount - 1)
-                    {
-                        int down = (row + 1) * ColCount + col;
-                        myFinder.addLink(n, down, 1);
-                    }
-                }
             return grid;
         }
         std::vector<std::string> cPathFinderReader::singleParentTree()
         {
             myFinder.clear();
+            myFinder.directed();
             if (!myFile.is_open())
                 throw std::runtime_error(
                     "cPathFinderReader::singleParentTree file not open");
@@ -48,6 +48,13 @@ namespace raven
             std::vector<int> valves(
                 bool &pulse);
 
+            /** Read input file specifying pipes and several valve schedules
+             * @param[out] pulse true if valves open every valve time
+             * @return valve timings, one vector for each 't' line
+             */
+            std::vector<std::vector<int>> valveSchedules(
+                bool &pulse);
+
             /** read input file with uncosted links
      * 
      * This expects nothing but links in src dst format
@@ -60,7 +67,12 @@ namespace raven
 
             void bonesi();
 
-            /// read tree
+            /** read prerequisites tree
+             * @return names of required skills
+             *
+             * Links are directed from prerequisite to skill.
+             * Each further 't' line adds another parent to the skills, making a DAG
+             */
             std::vector<std::string> singleParentTree();
 
             /** read cities with locations or links
@@ -71,10 +83,11 @@ namespace raven
             std::vector<int> sales();
 
             /** read orthogonal grid of cell values
-             * @return grid of cell values
+             * @return grid of cell values, with start and end cells
+             *
+             * No nodes or links are added to the pathfinder
              */
-            std::vector<std::vector<float>>
-            orthogonalGrid();
+            cGridGraph orthogonalGrid();
 
             /// read uncosted links, multiple links from one source on one line
             void multi();
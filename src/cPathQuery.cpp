@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <climits>
+#include <stdexcept>
+#include "cPathQuery.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// Dijkstra and A* can settle a node before a cheaper path through a negative link is found
+        static void checkCost(double cost)
+        {
+            if (cost < 0)
+                throw std::runtime_error(
+                    "cPathQuery negative link cost, use bellmanFord");
+        }
+
+        void cPathQuery::reset()
+        {
+            int V = myGraph->nodeCount();
+            if ((int)myReached.size() < V)
+            {
+                myDist.resize(V);
+                myBound.resize(V);
+                myPred.resize(V);
+                myHops.resize(V);
+                myReached.resize(V, 0);
+                myDone.resize(V, 0);
+            }
+
+            if (!++myGeneration)
+            {
+                // generation number wrapped, old stamps could match
+                std::fill(myReached.begin(), myReached.end(), 0);
+                std::fill(myDone.begin(), myDone.end(), 0);
+                myGeneration = 1;
+            }
+        }
+
+        void cPathQuery::begin(int start)
+        {
+            if (!myGraph || 0 > start || start >= myGraph->nodeCount())
+                throw std::runtime_error(
+                    "cPathQuery bad start node");
+            reset();
+            myStart = start;
+        }
+
+        void cPathQuery::classifyCosts()
+        {
+            // largest cost for Dial's bucket queue,
+            // empty buckets are stepped over one by one, so keep it small
+            const int maxBucketCost = 1024;
+
+            bool unit = true, zeroOne = true, integer = true;
+            double maxCost = 0;
+            for (auto &n : myGraph->graph())
+                for (auto &l : n.second.myLink)
+                {
+                    double c = l.second.myCost;
+                    if (c < 0)
+                    {
+                        myLinkCosts = eLinkCosts::any;
+                        return;
+                    }
+                    if (c != 1)
+                        unit = false;
+                    if (c != 0 && c != 1)
+                        zeroOne = false;
+                    if (c > maxBucketCost || c != (int)c)
+                        integer = false;
+                    maxCost = std::max(maxCost, c);
+                }
+            if (unit)
+                myLinkCosts = eLinkCosts::unit;
+            else if (zeroOne)
+                myLinkCosts = eLinkCosts::zeroOne;
+            else if (integer && maxCost <= maxBucketCost)
+                myLinkCosts = eLinkCosts::smallInteger;
+            else
+                myLinkCosts = eLinkCosts::any;
+            myMaxCost = maxCost;
+        }
+
+        void cPathQuery::search(
+            int start,
+            std::function<bool(int u)> settled)
+        {
+            begin(start);
+            reach(start, 0, -1);
+            switch (myLinkCosts)
+            {
+            case eLinkCosts::unit:
+                searchBreadth(settled);
+                break;
+            case eLinkCosts::zeroOne:
+                searchZeroOne(settled);
+                break;
+            case eLinkCosts::smallInteger:
+                searchBuckets(settled);
+                break;
+            default:
+                searchHeap(settled);
+                break;
+            }
+        }
+
+        void cPathQuery::searchHeap(std::function<bool(int u)> &settled)
+        {
+            auto &G = myGraph->graph();
+            std::greater<queued_t> cheaper;
+            myHeap.clear();
+            myHeap.push_back(std::make_pair(0.0, myStart));
+            while (myHeap.size())
+            {
+                std::pop_heap(myHeap.begin(), myHeap.end(), cheaper);
+                int u = myHeap.back().second;
+                myHeap.pop_back();
+                if (isDone(u))
+                    continue; // already reached more cheaply
+                myDone[u] = myGeneration;
+
+                if (!settled(u))
+                    return;
+
+                for (auto &l : G.at(u).myLink)
+                {
+                    int v = l.first;
+                    if (isDone(v))
+                        continue;
+                    checkCost(l.second.myCost);
+                    double dv = myDist[u] + l.second.myCost;
+                    if (!isReached(v) || dv < myDist[v])
+                    {
+                        reach(v, dv, u);
+                        myHeap.push_back(std::make_pair(dv, v));
+                        std::push_heap(myHeap.begin(), myHeap.end(), cheaper);
+                    }
+                }
+            }
+        }
+
+        void cPathQuery::searchBreadth(std::function<bool(int u)> &settled)
+        {
+            // every link costs 1, so the first path found to a node is the cheapest,
+            // and the nodes come out of the queue in order of cost
+            auto &G = myGraph->graph();
+            myQueue.clear();
+            myQueue.push_back(myStart);
+            for (int head = 0; head < (int)myQueue.size(); head++)
+            {
+                int u = myQueue[head];
+                myDone[u] = myGeneration;
+                if (!settled(u))
+                    return;
+                double dv = myDist[u] + 1;
+                for (auto &l : G.at(u).myLink)
+                {
+                    int v = l.first;
+                    if (isReached(v))
+                        continue;
+                    reach(v, dv, u);
+                    myQueue.push_back(v);
+                }
+            }
+        }
+
+        void cPathQuery::searchZeroOne(std::function<bool(int u)> &settled)
+        {
+            // nodes reached by a free link go to the front of the queue, others to the back,
+            // so the queue is always in order of cost, with at most two costs in it
+            auto &G = myGraph->graph();
+            myDeque.clear();
+            myDeque.push_back(myStart);
+            while (myDeque.size())
+            {
+                int u = myDeque.front();
+                myDeque.pop_front();
+                if (isDone(u))
+                    continue; // already reached more cheaply
+                myDone[u] = myGeneration;
+
+                if (!settled(u))
+                    return;
+
+                for (auto &l : G.at(u).myLink)
+                {
+                    int v = l.first;
+                    if (isDone(v))
+                        continue;
+                    double dv = myDist[u] + l.second.myCost;
+                    if (isReached(v) && dv >= myDist[v])
+                        continue;
+                    reach(v, dv, u);
+                    if (l.second.myCost == 0)
+                        myDeque.push_front(v);
+                    else
+                        myDeque.push_back(v);
+                }
+            }
+        }
+
+        void cPathQuery::searchBuckets(std::function<bool(int u)> &settled)
+        {
+            // Dial: bucket for each cost, in a cycle one longer than the largest link cost,
+            // so every node waiting is in a different bucket for each cost
+            auto &G = myGraph->graph();
+            int bucketCount = myMaxCost + 1;
+            if ((int)myBucket.size() != bucketCount)
+                myBucket.assign(bucketCount, std::vector<int>());
+            for (auto &b : myBucket)
+                b.clear();
+
+            myBucket[0].push_back(myStart);
+            int waiting = 1;
+            for (long long cost = 0; waiting; cost++)
+            {
+                auto &bucket = myBucket[cost % bucketCount];
+                // the bucket can grow while it is being emptied, by links that cost 0
+                for (int k = 0; k < (int)bucket.size(); k++)
+                {
+                    int u = bucket[k];
+                    waiting--;
+                    if (isDone(u) || myDist[u] != cost)
+                        continue; // already reached more cheaply
+                    myDone[u] = myGeneration;
+
+                    if (!settled(u))
+                        return;
+
+                    for (auto &l : G.at(u).myLink)
+                    {
+                        int v = l.first;
+                        if (isDone(v))
+                            continue;
+                        double dv = cost + l.second.myCost;
+                        if (isReached(v) && dv >= myDist[v])
+                            continue;
+                        reach(v, dv, u);
+                        myBucket[(long long)dv % bucketCount].push_back(v);
+                        waiting++;
+                    }
+                }
+                bucket.clear();
+            }
+        }
+
+        void cPathQuery::paths(
+            int start,
+            const std::vector<int> &target)
+        {
+            if (!target.size())
+            {
+                search(
+                    start,
+                    [](int)
+                    {
+                        return true;
+                    });
+                return;
+            }
+
+            // targets whose cheapest path is not yet known
+            // ( sizes buffers, so the targets can be marked before the search starts )
+            if (!myGraph || 0 > start || start >= myGraph->nodeCount())
+                throw std::runtime_error(
+                    "cPathQuery bad start node");
+            if ((int)myTarget.size() < myGraph->nodeCount())
+                myTarget.resize(myGraph->nodeCount(), false);
+            int targetCount = 0;
+            for (int t : target)
+            {
+                if (!myTarget[t])
+                    targetCount++;
+                myTarget[t] = true;
+            }
+
+            search(
+                start,
+                [&](int u)
+                {
+                    if (!myTarget[u])
+                        return true;
+                    myTarget[u] = false;
+                    return --targetCount > 0; // stop when all targets reached
+                });
+
+            // unmark targets that were not reachable, ready for next search
+            if (targetCount)
+                for (int t : target)
+                    myTarget[t] = false;
+        }
+
+        void cPathQuery::bellmanFord(const std::vector<int> &start)
+        {
+            if (!start.size())
+                throw std::runtime_error(
+                    "cPathQuery::bellmanFord no start node");
+            begin(start[0]);
+            int V = myGraph->nodeCount();
+            auto &G = myGraph->graph();
+
+            // nodes waiting to have their links looked at, marked in myDone
+            myQueue.clear();
+            for (int s : start)
+            {
+                if (0 > s || s >= V)
+                    throw std::runtime_error(
+                        "cPathQuery::bellmanFord bad start node");
+                if (isDone(s))
+                    continue;
+                reach(s, 0, -1);
+                myHops[s] = 0;
+                myDone[s] = myGeneration;
+                myQueue.push_back(s);
+            }
+
+            // myQueue used as a ring buffer, a node is never in it twice
+            int head = 0, count = myQueue.size();
+            myQueue.resize(V);
+            while (count)
+            {
+                int u = myQueue[head];
+                head = (head + 1) % V;
+                count--;
+                myDone[u] = 0;
+
+                for (auto &l : G.at(u).myLink)
+                {
+                    int v = l.first;
+                    double dv = myDist[u] + l.second.myCost;
+                    if (isReached(v) && dv >= myDist[v])
+                        continue;
+                    reach(v, dv, u);
+                    myHops[v] = myHops[u] + 1;
+                    if (myHops[v] >= V)
+                        throw std::runtime_error(
+                            "cPathQuery::bellmanFord negative cost cycle");
+                    if (isDone(v))
+                        continue; // already waiting
+                    myDone[v] = myGeneration;
+                    myQueue[(head + count) % V] = v;
+                    count++;
+                }
+            }
+        }
+
+        void cPathQuery::astar(
+            int start,
+            int end,
+            std::function<double(int n)> bound)
+        {
+            begin(start);
+            if (0 > end || end >= myGraph->nodeCount())
+                throw std::runtime_error(
+                    "cPathQuery::astar bad end node");
+            auto &G = myGraph->graph();
+
+            // heap ordered by cost from start plus bound of cost to end
+            std::greater<queued_t> cheaper;
+            myHeap.clear();
+            reach(start, 0, -1);
+            myBound[start] = bound(start);
+            myHeap.push_back(std::make_pair(myBound[start], start));
+            while (myHeap.size())
+            {
+                std::pop_heap(myHeap.begin(), myHeap.end(), cheaper);
+                double f = myHeap.back().first;
+                int u = myHeap.back().second;
+                myHeap.pop_back();
+                if (f > myDist[u] + myBound[u])
+                    continue; // already reached more cheaply
+                if (u == end)
+                    return;
+
+                for (auto &l : G.at(u).myLink)
+                {
+                    int v = l.first;
+                    checkCost(l.second.myCost);
+                    double dv = myDist[u] + l.second.myCost;
+                    if (!isReached(v))
+                        myBound[v] = bound(v);
+                    else if (dv >= myDist[v])
+                        continue;
+                    reach(v, dv, u);
+                    myHeap.push_back(std::make_pair(dv + myBound[v], v));
+                    std::push_heap(myHeap.begin(), myHeap.end(), cheaper);
+                }
+            }
+        }
+
+        std::vector<std::pair<int, double>> cPathQuery::within(
+            int start,
+            double radius)
+        {
+            std::vector<std::pair<int, double>> ret;
+            search(
+                start,
+                [&](int u)
+                {
+                    if (myDist[u] > radius)
+                        return false;
+                    ret.push_back(std::make_pair(u, myDist[u]));
+                    return true;
+                });
+            return ret;
+        }
+
+        std::vector<std::pair<int, double>> cPathQuery::nearest(
+            int start,
+            int k,
+            std::function<bool(int n)> accept)
+        {
+            std::vector<std::pair<int, double>> ret;
+            if (k <= 0)
+                return ret;
+            search(
+                start,
+                [&](int u)
+                {
+                    if (u == start || (accept && !accept(u)))
+                        return true;
+                    ret.push_back(std::make_pair(u, myDist[u]));
+                    return (int)ret.size() < k;
+                });
+            return ret;
+        }
+
+        std::vector<int> cPathQuery::path(int end) const
+        {
+            std::vector<int> ret;
+            if (myStart < 0 || 0 > end || end >= (int)myDist.size() || !isReached(end))
+                return ret;
+            for (int n = end; n != -1; n = myPred[n])
+                ret.push_back(n);
+            std::reverse(ret.begin(), ret.end());
+            return ret;
+        }
+
+        bool cPathQuery::depthFirst(
+            int start,
+            std::function<bool(int v)> visitor)
+        {
+            reset();
+            auto &G = myGraph->graph();
+
+            myStack.clear();
+            myDone[start] = myGeneration;
+            if (!visitor(start))
+                return true;
+            myStack.push_back(std::make_pair(start, G.at(start).myLink.begin()));
+            while (myStack.size())
+            {
+                auto &top = myStack.back();
+                if (top.second == G.at(top.first).myLink.end())
+                {
+                    // all links from this node followed, back up
+                    myStack.pop_back();
+                    continue;
+                }
+                int w = top.second->first;
+                top.second++;
+                if (isDone(w))
+                    continue;
+                myDone[w] = myGeneration;
+                if (!visitor(w))
+                    return true;
+                myStack.push_back(std::make_pair(w, G.at(w).myLink.begin()));
+            }
+            return false;
+        }
+
+        void cPathQuery::breadth(
+            int start,
+            std::function<void(int v, int p)> visitor)
+        {
+            reset();
+            auto &G = myGraph->graph();
+
+            myQueue.clear();
+            myDone[start] = myGeneration;
+            myQueue.push_back(start);
+            for (int head = 0; head < (int)myQueue.size(); head++)
+            {
+                int v = myQueue[head];
+                for (auto &l : G.at(v).myLink)
+                {
+                    int w = l.first;
+                    if (isDone(w))
+                        continue;
+                    // reached a new node
+                    visitor(w, v);
+                    myDone[w] = myGeneration;
+                    myQueue.push_back(w);
+                }
+            }
+        }
+    }
+}
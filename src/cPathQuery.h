@@ -0,0 +1,278 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <functional>
+#include "cGraph.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// what is known about the link costs, so a faster queue can be used by Dijkstra
+        enum class eLinkCosts
+        {
+            any,          // heap
+            unit,         // every cost 1, breadth first search
+            zeroOne,      // every cost 0 or 1, 0-1 BFS with a double ended queue
+            smallInteger, // whole numbers up to a small maximum, Dial's bucket queue
+        };
+
+        /** @brief Path searches on a shared graph, with their own working buffers
+         *
+         * The graph is only read, so any number of queries can run
+         * concurrently on one graph, each thread using its own cPathQuery.
+         * A cPathQuery must not be used by two threads at once,
+         * and the graph must not be changed while queries are running on it.
+         *
+         * The buffers are kept between searches,
+         * so a cPathQuery reused for many searches allocates memory only once.
+         * Each search has a generation number, and a node's buffer entries
+         * are valid only if stamped with the current generation,
+         * so starting a new search does not clear the buffers.
+         * A search that reaches k nodes takes time proportional to k,
+         * not to the number of nodes in the graph.
+         *
+         * <pre>
+            cPathQuery q( graph );
+            q.paths( start );
+            auto path = q.path( end );
+            double cost = q.dist( end );
+           </pre>
+         */
+        class cPathQuery
+        {
+        public:
+            cPathQuery()
+                : myGraph(nullptr), myStart(-1), myGeneration(0),
+                  myLinkCosts(eLinkCosts::any), myMaxCost(0)
+            {
+            }
+            cPathQuery(const cGraph &g)
+                : myGraph(&g), myStart(-1), myGeneration(0),
+                  myLinkCosts(eLinkCosts::any), myMaxCost(0)
+            {
+            }
+
+            /** set graph to search
+             *
+             * The buffers are kept, so one cPathQuery can serve several graphs in turn
+             */
+            void graph(const cGraph &g)
+            {
+                myGraph = &g;
+                myStart = -1;
+                myLinkCosts = eLinkCosts::any;
+            }
+
+            /** Look at every link cost, so the Dijkstra searches can use the fastest queue
+             *
+             * Takes time proportional to the number of links,
+             * so worth doing before a search of the whole graph,
+             * or before many searches if the graph does not change.
+             * Until called, a heap is used, which works for any costs that are not negative.
+             */
+            void classifyCosts();
+
+            /// what is known about link costs, from classifyCosts()
+            eLinkCosts linkCosts() const
+            {
+                return myLinkCosts;
+            }
+
+            /** Dijkstra search from start
+             * @param[in] start node index
+             * @param[in] target node indices, search stops when cheapest paths to all are known.
+             *    If empty, the cheapest paths to every reachable node are found
+             *
+             * Link costs must not be negative, use bellmanFord() if they may be.
+             * Exception thrown if start is not a node in the graph, or a negative link cost is met
+             */
+            void paths(
+                int start,
+                const std::vector<int> &target = std::vector<int>());
+
+            /** Cheapest paths from start, allowing negative link costs
+             * @param[in] start node indices, each with path cost 0
+             *
+             * Queue based Bellman-Ford ( SPFA ):
+             * a node is queued again whenever a cheaper path to it is found.
+             * Usually close to linear time, O(VE) at worst.
+             *
+             * Exception thrown if a negative cost cycle can be reached from start,
+             * found when a path would need more links than there are nodes.
+             */
+            void bellmanFord(const std::vector<int> &start);
+
+            /** A* search from start to end
+             * @param[in] start node index
+             * @param[in] end node index
+             * @param[in] bound function returning a lower bound of the path cost from a node to end.
+             *    Must never overestimate, or the path found may not be the cheapest
+             *
+             * The search stops when the cheapest path to end is known,
+             * afterwards path( end ) gives the path.
+             * Nodes are looked at again if a cheaper path to them is found,
+             * so the bound need not be consistent.
+             * Exception thrown if a negative link cost is met
+             */
+            void astar(
+                int start,
+                int end,
+                std::function<double(int n)> bound);
+
+            /** Nodes that can be reached from start within a cost
+             * @param[in] start node index
+             * @param[in] radius maximum path cost
+             * @return node index and path cost pairs, cheapest first, starting with start
+             *
+             * The search stops at the radius,
+             * so time depends on the number of nodes found, not the size of the graph.
+             * Afterwards path() gives the path to any node found
+             *
+             * Exception thrown if a negative link cost is met.
+             * A search that stops early may not meet one,
+             * so use cPathFinder::within() if link costs may be negative.
+             */
+            std::vector<std::pair<int, double>> within(
+                int start,
+                double radius);
+
+            /** Nearest nodes, by path cost, that meet a condition
+             * @param[in] start node index
+             * @param[in] k number of nodes wanted
+             * @param[in] accept function returning true for wanted nodes, null for any node
+             * @return node index and path cost pairs, cheapest first, not including start.
+             *    Fewer than k if the search runs out of reachable nodes
+             *
+             * The search stops when the k-th node is found.
+             * Exception thrown if a negative link cost is met,
+             * use cPathFinder::nearest() if link costs may be negative.
+             */
+            std::vector<std::pair<int, double>> nearest(
+                int start,
+                int k,
+                std::function<bool(int n)> accept = nullptr);
+
+            /** Cheapest path found by last call to paths()
+             * @param[in] end node index
+             * @return node indices on path, start first, empty if end was not reached
+             */
+            std::vector<int> path(int end) const;
+
+            /// cost of cheapest path from start, INT_MAX if not reached
+            double dist(int n) const
+            {
+                if (!isReached(n))
+                    return INT_MAX;
+                return myDist[n];
+            }
+
+            /// previous node on cheapest path from start, -1 if not reached or start
+            int pred(int n) const
+            {
+                if (!isReached(n))
+                    return -1;
+                return myPred[n];
+            }
+
+            /// starting node of last search
+            int start() const
+            {
+                return myStart;
+            }
+
+            /** Depth first search
+             * @param[in] start node index
+             * @param[in] visitor function to call on each new node visited, starting with start.
+             *    Return false to stop the search
+             * @return true if the search was stopped by the visitor
+             *
+             * Nodes are visited in the same order as a recursive search,
+             * but without recursion so large graphs do not overflow the call stack
+             */
+            bool depthFirst(
+                int start,
+                std::function<bool(int v)> visitor);
+
+            /** Breadth first search
+             * @param[in] start node index
+             * @param[in] visitor function to call on each new node visited,
+             *    with the node it was reached from. Not called for start
+             */
+            void breadth(
+                int start,
+                std::function<void(int v, int p)> visitor);
+
+        private:
+            const cGraph *myGraph;
+            int myStart;
+
+            /// current search, stamped on the nodes it reaches
+            unsigned myGeneration;
+
+            std::vector<double> myDist;      // cost of cheapest path from start
+            std::vector<double> myBound;     // A* lower bound of cost to end
+            std::vector<int> myPred;         // previous node on cheapest path
+            std::vector<int> myHops;         // Bellman-Ford number of links in path
+            std::vector<unsigned> myReached; // generation that set myDist and myPred
+            std::vector<unsigned> myDone;    // generation that visited node, or found its cheapest path
+            std::vector<bool> myTarget;      // true if search can stop when node's cheapest path is known
+
+            typedef std::pair<double, int> queued_t; // ( cost from start, node index )
+            std::vector<queued_t> myHeap;            // nodes waiting, cheapest first
+            std::vector<int> myQueue;                // nodes waiting, breadth first or Bellman-Ford
+            std::deque<int> myDeque;                 // nodes waiting, 0-1 BFS
+            std::vector<std::vector<int>> myBucket;  // nodes waiting, by cost modulo bucket count
+
+            eLinkCosts myLinkCosts;
+            int myMaxCost; // largest link cost, if whole numbers
+
+            /// nodes on depth first path, with their next link to look at
+            std::vector<std::pair<int, nodeOutEdgesMap_t::const_iterator>> myStack;
+
+            /// check start node, then start new search from it
+            void begin(int start);
+
+            /** Dijkstra search from start
+             * @param[in] start node index
+             * @param[in] settled function called with each node, cheapest first,
+             *    when its cheapest path is known. Return false to stop the search
+             *
+             * The nodes waiting are kept in the fastest queue that suits the link costs
+             */
+            void search(
+                int start,
+                std::function<bool(int u)> settled);
+
+            void searchHeap(std::function<bool(int u)> &settled);
+            void searchBreadth(std::function<bool(int u)> &settled);
+            void searchZeroOne(std::function<bool(int u)> &settled);
+            void searchBuckets(std::function<bool(int u)> &settled);
+
+            /** start a new search generation
+             *
+             * Grows the buffers if the graph has grown.
+             * Every node is then not reached, without touching the buffers,
+             * except once in 4 billion searches when the generation number wraps.
+             */
+            void reset();
+
+            bool isReached(int n) const
+            {
+                return myReached[n] == myGeneration;
+            }
+            bool isDone(int n) const
+            {
+                return myDone[n] == myGeneration;
+            }
+
+            /// set cost and previous node, marking node reached in this search
+            void reach(int n, double dist, int pred)
+            {
+                myDist[n] = dist;
+                myPred[n] = pred;
+                myReached[n] = myGeneration;
+            }
+        };
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief Fast seeded pseudo random number generator
+         *
+         * xoshiro256** https://prng.di.unimi.it/
+         *
+         * The same seed always gives the same sequence, on every platform,
+         * unlike rand()
+         */
+        class cRandom
+        {
+        public:
+            cRandom(uint64_t seed = 1)
+            {
+                this->seed(seed);
+            }
+
+            /// restart sequence from seed
+            void seed(uint64_t seed)
+            {
+                // expand seed into state with splitmix64
+                for (auto &s : myState)
+                {
+                    seed += 0x9e3779b97f4a7c15;
+                    uint64_t z = seed;
+                    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+                    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+                    s = z ^ (z >> 31);
+                }
+            }
+
+            /// next 64 bit random number
+            uint64_t next()
+            {
+                uint64_t result = rotl(myState[1] * 5, 7) * 9;
+                uint64_t t = myState[1] << 17;
+                myState[2] ^= myState[0];
+                myState[3] ^= myState[1];
+                myState[1] ^= myState[2];
+                myState[0] ^= myState[3];
+                myState[2] ^= t;
+                myState[3] = rotl(myState[3], 45);
+                return result;
+            }
+
+            /// random integer from 0 to n - 1
+            int operator()(int n)
+            {
+                return (int)(((next() >> 32) * (uint64_t)n) >> 32);
+            }
+
+        private:
+            uint64_t myState[4];
+
+            static uint64_t rotl(uint64_t x, int k)
+            {
+                return (x << k) | (x >> (64 - k));
+            }
+        };
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <vector>
+#include <stdexcept>
+
+namespace raven
+{
+    namespace graph
+    {
+        /** @brief 2D grid of values stored in one buffer, in square tiles
+         *
+         * The grid is divided into tiles of 2^TileBits by 2^TileBits cells.
+         * The cells of a tile are stored together, row by row,
+         * and the tiles are stored row by row.
+         *
+         * Cells above and below each other are then usually in the same tile,
+         * only a few cache lines apart, instead of a whole grid row apart.
+         *
+         * Cells can be accessed by row and column,
+         * by row-major linear index ( row * colCount + col ),
+         * or by offset into the buffer, which is fastest.
+         * The buffer is padded to a whole number of tiles,
+         * the padding cells have no row or column in the grid.
+         */
+        template <class T, int TileBits = 3>
+        class cTiledGrid
+        {
+        public:
+            cTiledGrid()
+                : myRowCount(0), myColCount(0), myTileCols(0)
+            {
+            }
+
+            /** set grid size
+             * @param[in] rowCount
+             * @param[in] colCount
+             * @param[in] value initial value of every cell
+             */
+            void size(int rowCount, int colCount, const T &value = T())
+            {
+                if (rowCount < 0 || colCount < 0)
+                    throw std::runtime_error(
+                        "cTiledGrid::size bad size");
+                myRowCount = rowCount;
+                myColCount = colCount;
+                myTileCols = (colCount + TileSide - 1) >> TileBits;
+                int tileRows = (rowCount + TileSide - 1) >> TileBits;
+                myBuffer.clear();
+                myBuffer.resize(
+                    (size_t)tileRows * myTileCols * TileSide * TileSide,
+                    value);
+            }
+
+            int rowCount() const
+            {
+                return myRowCount;
+            }
+            int colCount() const
+            {
+                return myColCount;
+            }
+
+            /// number of cells in buffer, including padding
+            int bufferSize() const
+            {
+                return (int)myBuffer.size();
+            }
+
+            /// buffer offset of cell
+            int offset(int row, int col) const
+            {
+                int tile = (row >> TileBits) * myTileCols + (col >> TileBits);
+                return (tile << (2 * TileBits)) |
+                       ((row & TileMask) << TileBits) |
+                       (col & TileMask);
+            }
+
+            /// row of cell at buffer offset
+            int row(int offset) const
+            {
+                int tile = offset >> (2 * TileBits);
+                return ((tile / myTileCols) << TileBits) |
+                       ((offset >> TileBits) & TileMask);
+            }
+
+            /// column of cell at buffer offset
+            int col(int offset) const
+            {
+                int tile = offset >> (2 * TileBits);
+                return ((tile % myTileCols) << TileBits) |
+                       (offset & TileMask);
+            }
+
+            /// cell value by row and column
+            T &operator()(int row, int col)
+            {
+                return myBuffer[offset(row, col)];
+            }
+            const T &operator()(int row, int col) const
+            {
+                return myBuffer[offset(row, col)];
+            }
+
+            /// cell value by row-major linear index
+            T &at(int linear)
+            {
+                return (*this)(linear / myColCount, linear % myColCount);
+            }
+            const T &at(int linear) const
+            {
+                return (*this)(linear / myColCount, linear % myColCount);
+            }
+
+            /// cell value by buffer offset
+            T &operator[](int offset)
+            {
+                return myBuffer[offset];
+            }
+            const T &operator[](int offset) const
+            {
+                return myBuffer[offset];
+            }
+
+        private:
+            static const int TileSide = 1 << TileBits;
+            static const int TileMask = TileSide - 1;
+
+            int myRowCount;
+            int myColCount;
+            int myTileCols; // number of tiles across the grid
+            std::vector<T> myBuffer;
+        };
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace raven
+{
+    namespace graph
+    {
+        /** run worker on a pool of threads, one per hardware thread
+         * @param[in] worker function taking tasks until none are left
+         * @param[in] taskCount number of tasks, no more threads are started
+         *
+         * An exception thrown by a worker is thrown again, once every thread has finished,
+         * so the caller sees the same exception as if the tasks were run one by one.
+         */
+        inline void runWorkers(
+            const std::function<void()> &worker,
+            int taskCount)
+        {
+            int workerCount = std::thread::hardware_concurrency();
+            if (workerCount < 1)
+                workerCount = 1;
+            if (workerCount > taskCount)
+                workerCount = taskCount;
+
+            std::exception_ptr error;
+            std::mutex errorMutex;
+            std::vector<std::thread> vThread;
+            for (int k = 0; k < workerCount; k++)
+                vThread.emplace_back(
+                    [&]()
+                    {
+                        try
+                        {
+                            worker();
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(errorMutex);
+                            if (!error)
+                                error = std::current_exception();
+                        }
+                    });
+            for (auto &t : vThread)
+                t.join();
+            if (error)
+                std::rethrow_exception(error);
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "cutest.h"
 #include "cGraph.h"
+#include "cTiledGrid.h"
 
 using namespace raven::graph;
 
@@ -41,6 +42,43 @@ TEST(links)
 
 }
 
+TEST(tiledgrid)
+{
+    cTiledGrid<float> grid;
+    grid.size(11, 13);
+
+    for (int row = 0; row < 11; row++)
+        for (int col = 0; col < 13; col++)
+            grid(row, col) = row * 100 + col;
+
+    CHECK_EQUAL(1012, grid.at(10 * 13 + 12));
+    int off = grid.offset(9, 12);
+    CHECK_EQUAL(9, grid.row(off));
+    CHECK_EQUAL(12, grid.col(off));
+    CHECK_EQUAL(912, grid[off]);
+
+    // cell below is in the same tile
+    CHECK_EQUAL(8, grid.offset(1, 2) - grid.offset(0, 2));
+}
+
+TEST(attributes)
+{
+    cGraph g;
+    int a = g.findoradd("a");
+    int b = g.findoradd("b");
+    g.location(b, 3.5, -2);
+    g.weight(b, 7);
+    g.role(a, eNodeRole::driver);
+
+    CHECK_EQUAL(3.5, g.x(b));
+    CHECK_EQUAL(-2, g.y(b));
+    CHECK_EQUAL(0, g.x(a));
+    CHECK_EQUAL(7, g.weight(b));
+    CHECK_EQUAL(0, g.weight(a));
+    CHECK_EQUAL((int)eNodeRole::driver, (int)g.role(a));
+    CHECK_EQUAL((int)eNodeRole::none, (int)g.role(b));
+}
+
 int main()
 {
     raven::set::UnitTest::RunAllTests();
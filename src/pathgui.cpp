@@ -56,6 +56,7 @@ void RunDOT(raven::graph::cPathFinder &finder)
     case eCalculation::sales:
     case eCalculation::bonesi:
     case eCalculation::srcnuzn:
+    case eCalculation::waterschedules:
         f << finder.pathViz() << "\n";
         break;
     case eCalculation::spans:
@@ -66,6 +67,7 @@ void RunDOT(raven::graph::cPathFinder &finder)
         f << finder.camsViz() << "\n";
         break;
     case eCalculation::pickup:
+    case eCalculation::pickupcapacity:
         f << finder.pickupViz() << "\n";
         break;
     default:
@@ -308,9 +310,16 @@ int main()
                             finder.pickup();
                             opt = eCalculation::pickup;
                             break;
+                        case eCalculation::pickupcapacity:
+                            finder.pickupCapacity();
+                            opt = eCalculation::pickupcapacity;
+                            break;
                         case eCalculation::allpaths:
                             finder.allPaths();
                             break;
+                        case eCalculation::waterschedules:
+                            opt = eCalculation::waterschedules;
+                            break;
                          default:
                              throw std::runtime_error(
                                  "UNrecognized file format");
@@ -357,6 +366,8 @@ int main()
                 break;
             case eCalculation::reqs:
             case eCalculation::pickup:
+            case eCalculation::pickupcapacity:
+            case eCalculation::waterschedules:
                 s.text(
                     finder.resultsText(),
                     {5, 5});
@@ -1,6 +1,8 @@
 // PathFinder unit tests
 
 #include <iostream>
+#include <cmath>
+#include <thread>
 
 #include "cPathFinderReader.h"
 #include "cGraph.h"
@@ -40,6 +42,33 @@ main()
     // int i;
     // std::cin >> i;
 
+    std::cout << "TEST pickup3.txt\n";
+    reader.open("../dat/pickup3.txt");
+    finder.pickup();
+    expected = "d1 -> c1 -> c2 -> end -> \n\rd2 -> c3 -> c4 -> end -> \n\r";
+    if (expected != finder.resultsText())
+        throw std::runtime_error("pickup3.txt failed");
+
+    std::cout << "TEST pickupcap.txt\n";
+    reader.open("../dat/pickupcap.txt");
+    finder.pickupCapacity();
+    expected = "d1 -> c2 -> c1 -> c3 -> end -> \n\r"
+               "d2 -> c4 -> c5 -> end -> \n\r"
+               "d3 -> c7 -> c6 -> end -> \n\r"
+               "unassigned c8\n\r";
+    if (expected != finder.resultsText())
+        throw std::runtime_error("pickupcap.txt failed");
+
+    // mixed fleet, one large vehicle and small ones that each take one cargo
+    std::cout << "TEST pickupcap2.txt\n";
+    reader.open("../dat/pickupcap2.txt");
+    finder.pickupCapacity();
+    expected = "d1 -> c2 -> c1 -> c3 -> c4 -> end -> \n\r"
+               "d2 -> c5 -> end -> \n\r"
+               "d4 -> c6 -> end -> \n\r";
+    if (expected != finder.resultsText())
+        throw std::runtime_error("pickupcap2.txt failed");
+
     std::cout << "pickup timer test\n";
     reader.open("../dat/manhatten.txt");
     // int i;
@@ -52,6 +81,13 @@ main()
     if (expected != finder.resultsText())
         throw std::runtime_error("t2.txt failed");
 
+    // prerequisites with more than one parent
+    std::cout << "TEST prereqdag.txt\n";
+    reader.open("../dat/prereqdag.txt");
+    expected = "Total skills needed 4 (";
+    if (finder.resultsText().find(expected) != 0)
+        throw std::runtime_error("prereqdag.txt failed");
+
     // link cover
     std::cout << "TEST cover3.txt\n";
     reader.open("../dat/cover3.txt");
@@ -64,12 +100,112 @@ main()
     expected = "1 -> 2 -> 3 -> 4 ->  Cost is 3\n";
     if (expected != finder.pathText())
         throw std::runtime_error("costs.txt failed");
+    {
+        // whole number costs, so path found with bucket queue
+        raven::graph::cPathQuery query(finder);
+        query.classifyCosts();
+        if (query.linkCosts() != raven::graph::eLinkCosts::smallInteger)
+            throw std::runtime_error("costs.txt classifyCosts failed");
+    }
+
+    // path back found by delta-stepping
+    finder.start("4");
+    finder.pathsParallel(finder.find("4"), 0.5);
+    finder.pathPick(finder.find("1"));
+    if ("4 -> 3 -> 2 -> 1 ->  Cost is 3\n" != finder.pathText())
+        throw std::runtime_error("costs.txt delta-stepping failed");
 
     // Dijsktra - all link costs equal so choose shortest path
     reader.open("../dat/costs2.txt");
     expected = "1 -> 2 -> 4 ->  Cost is 2\n";
     if (expected != finder.pathText())
         throw std::runtime_error("costs2.txt failed");
+    {
+        // every cost 1, so path found by breadth first search
+        raven::graph::cPathQuery query(finder);
+        query.classifyCosts();
+        if (query.linkCosts() != raven::graph::eLinkCosts::unit)
+            throw std::runtime_error("costs2.txt classifyCosts failed");
+    }
+
+    // same path found by contraction hierarchy
+    finder.contract();
+    finder.path();
+    if (expected != finder.pathText())
+        throw std::runtime_error("costs2.txt contraction failed");
+
+    // hierarchy not used after graph changes
+    finder.findLink(finder.find("2"), finder.find("4")).myCost = 5;
+    finder.path();
+    if ("1 -> 2 -> 3 -> 4 ->  Cost is 3\n" != finder.pathText())
+        throw std::runtime_error("costs2.txt contraction after change failed");
+
+    // same path found by A* with landmark bounds
+    reader.open("../dat/costs2.txt");
+    finder.landmarks(2);
+    finder.path();
+    if (expected != finder.pathText())
+        throw std::runtime_error("costs2.txt landmarks failed");
+
+    // path queries from several threads at once on one graph
+    {
+        std::vector<std::vector<int>> vPath(4);
+        std::vector<std::thread> vThread;
+        for (int k = 0; k < 4; k++)
+            vThread.emplace_back(
+                [&, k]()
+                {
+                    // reuse query, so second search must ignore what the first found
+                    raven::graph::cPathQuery query(finder);
+                    query.paths(finder.find("3"));
+                    query.paths(finder.find("1"));
+                    vPath[k] = query.path(finder.find("4"));
+                });
+        for (auto &t : vThread)
+            t.join();
+        for (auto &path : vPath)
+            if (path.size() != 3 || path[1] != finder.find("2"))
+                throw std::runtime_error("costs2.txt cPathQuery failed");
+    }
+
+    // Bellman-Ford - negative link cost
+    std::cout << "TEST negative.txt\n";
+    reader.open("../dat/negative.txt");
+    expected = "a -> c -> b -> d ->  Cost is 1.5\n";
+    if (expected != finder.pathText())
+        throw std::runtime_error("negative.txt failed");
+
+    // same path after Johnson reweighting
+    finder.makeCostsPositive();
+    finder.path();
+    if (expected != finder.pathText() ||
+        finder.cost(finder.find("c"), finder.find("b")) != -1.5)
+        throw std::runtime_error("negative.txt reweighting failed");
+    finder.contract();
+    finder.path();
+    if (expected != finder.pathText())
+        throw std::runtime_error("negative.txt reweighted contraction failed");
+    reader.open("../dat/negative.txt");
+    finder.makeCostsPositive();
+    finder.landmarks(2);
+    finder.path();
+    if (expected != finder.pathText())
+        throw std::runtime_error("negative.txt reweighted landmarks failed");
+
+    // costs from a, true cost of b is 0.5, reached by a link costing more than the radius
+    {
+        auto vr = finder.within(finder.find("a"), 1);
+        auto vm = finder.distanceMatrix({finder.find("a")}, {finder.find("b")});
+        if (vr.size() != 2 || vr[1].first != finder.find("b") || vr[1].second != 0.5 ||
+            vm[0] != 0.5)
+            throw std::runtime_error("negative.txt within failed");
+    }
+
+    // path with negative cost
+    std::cout << "TEST negative2.txt\n";
+    reader.open("../dat/negative2.txt");
+    if ("a -> b -> c ->  Cost is -1\n" != finder.pathText())
+        throw std::runtime_error("negative2.txt failed");
 
     // Spanning tree
     std::cout << "TEST span.txt\n";
@@ -83,11 +219,87 @@ main()
     // Metric approx travelling salesman
     std::cout << "TEST sales.txt\n";
     reader.open("../dat/sales.txt");
-    expected = "b -> a -> f -> d -> e -> c -> b ->  Cost is 16\n";
+    expected = "a -> f -> e -> d -> c -> b -> a ->  Cost is 17.7213\n";
     std::cout << finder.pathText() << "\n";
     if (expected != finder.pathText())
         throw std::runtime_error("sales.txt failed");
 
+    std::cout << "TEST salesmulti.txt\n";
+    reader.open("../dat/salesmulti.txt");
+    expected = "a -> f -> e -> d -> c -> b -> a -> ";
+    if (finder.pathText().find(expected) != 0)
+        throw std::runtime_error("salesmulti.txt failed");
+
+    // time limit too short for any tour, so the first starting tour, same as tsp()
+    finder.tspMultiStart(0, 1e-9);
+    if (finder.pathText().find(expected) != 0)
+        throw std::runtime_error("salesmulti.txt time limit failed");
+
+    {
+        // directed, cheap one way round the ring, dear the other way
+        std::cout << "TEST directed tsp\n";
+        raven::graph::cPathFinder ring;
+        ring.directed();
+        std::vector<std::string> name{"a", "b", "c", "d", "e", "f"};
+        for (int i = 0; i < 6; i++)
+            for (int j = 0; j < 6; j++)
+            {
+                if (i == j)
+                    continue;
+                double cost = 5;
+                if (j == (i + 1) % 6)
+                    cost = 1;
+                else if (i == (j + 1) % 6)
+                    cost = 20;
+                ring.addLink(name[i], name[j], cost);
+            }
+        ring.tsp();
+        if (ring.pathText() != "b -> c -> d -> e -> f -> a -> b -> ")
+            throw std::runtime_error("directed tsp failed");
+    }
+
+    std::cout << "TEST salesvisit.txt\n";
+    reader.open("../dat/salesvisit.txt");
+    expected = "c2 -> c4 -> c3 -> c4 -> c2 ->  Cost is 5.65684\n";
+    if (expected != finder.pathText())
+        throw std::runtime_error("salesvisit.txt failed");
+    {
+        std::vector<std::vector<int>> vPred;
+        auto cost = finder.distanceMatrix(
+            {finder.find("c1"), finder.find("c5")},
+            {finder.find("c4"), finder.find("c6")},
+            &vPred);
+        if (fabs(cost[0] - 6.41421) > 0.0001 ||
+            fabs(cost[3] - 6.7082) > 0.0001 ||
+            vPred[0][finder.find("c4")] != finder.find("c2"))
+            throw std::runtime_error("salesvisit.txt distanceMatrix failed");
+    }
+    {
+        // exception thrown by a worker thread reaches the caller
+        bool thrown = false;
+        try
+        {
+            finder.distanceMatrix({-1}, {finder.find("c4")});
+        }
+        catch (std::runtime_error &)
+        {
+            thrown = true;
+        }
+        if (!thrown)
+            throw std::runtime_error("salesvisit.txt distanceMatrix bad source failed");
+    }
+    {
+        auto vr = finder.within(finder.find("c2"), 3);
+        if (vr.size() != 4 || vr[0].first != finder.find("c2") ||
+            vr[2].first != finder.find("c3") || fabs(vr[2].second - 2.82842) > 0.0001 ||
+            vr[3].first != finder.find("c6"))
+            throw std::runtime_error("salesvisit.txt within failed");
+        auto vn = finder.nearest(finder.find("c1"), 2);
+        if (vn.size() != 2 || vn[0].first != finder.find("c2") ||
+            vn[1].first != finder.find("c3"))
+            throw std::runtime_error("salesvisit.txt nearest failed");
+    }
+
     std::cout << "TEST cliques.txt\n";
     reader.open("../dat/cliques.txt");
     finder.cliques();
@@ -119,10 +331,31 @@ main()
         throw std::runtime_error("flows8.txt failed");
 
     reader.open("../dat/hill.txt");
-    expected = "c1r1 -> c1r2 -> c1r3 -> c2r3 -> c3r3 ->  Cost is 4\n";
+    expected = "c1r1 -> c2r1 -> c3r1 -> c3r2 -> c3r3 ->  Cost is 8\n";
     if (finder.resultsText().find(expected) == -1)
         throw std::runtime_error("hill.txt failed");
 
+    // ascii art maze
+    std::cout << "TEST maze1.txt\n";
+    reader.open("../dat/maze1.txt");
+    expected = "c5r4 -> c4r4 -> c3r4 -> c3r5 -> c4r5 -> c5r5 -> END ->  Cost is 16\n";
+    if (finder.pathText().find(expected) == -1)
+        throw std::runtime_error("maze1.txt failed");
+
+    // pipes with timed valves
+    std::cout << "TEST water1.txt\n";
+    reader.open("../dat/water1.txt");
+    expected = "1 -> 3 -> 5 -> 6 -> ";
+    if (finder.pathText().find(expected) != 0)
+        throw std::runtime_error("water1.txt failed");
+
+    // several valve schedules on one pipe network
+    std::cout << "TEST water2.txt\n";
+    reader.open("../dat/water2.txt");
+    expected = "schedule 2 water reached 6 at time 21";
+    if (finder.resultsText().find(expected) == -1)
+        throw std::runtime_error("water2.txt failed");
+
     //reader.open("../dat/flows4.txt");
     //reader.open("../dat/flows5.txt");
 